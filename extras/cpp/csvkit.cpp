@@ -10,6 +10,7 @@
 
 #include "csvkit.hpp"
 #include <cstring>
+#include <exception>
 
 namespace csvkit {
 
@@ -69,7 +70,92 @@ Config& Config::strict_mode(bool strict) {
     return *this;
 }
 
+Config& Config::buffer_size(size_t size) {
+    config_.buffer_size = size;
+    return *this;
+}
+
+Config& Config::use_mmap(bool enable) {
+    config_.use_mmap = enable;
+    return *this;
+}
+
+Config& Config::structural_index(bool enable) {
+    config_.structural_index = enable;
+    return *this;
+}
+
+Config& Config::threads(unsigned count) {
+    config_.threads = count;
+    return *this;
+}
+
+Config& Config::read_ahead(unsigned buffers) {
+    config_.read_ahead = buffers;
+    return *this;
+}
+
+Config& Config::direct_io(bool enable) {
+    config_.direct_io = enable;
+    return *this;
+}
+
+Config& Config::decompress(bool enable) {
+    config_.decompress = enable;
+    return *this;
+}
+
+Config& Config::has_header(bool header) {
+    config_.has_header = header;
+    return *this;
+}
+
+Config& Config::compression(csvkit_compression_t format, int level) {
+    config_.compression = format;
+    config_.compression_level = level;
+    return *this;
+}
+
+Config& Config::compression_threads(unsigned count) {
+    config_.compression_threads = count;
+    return *this;
+}
+
+Config& Config::columns(const std::vector<size_t>& indexes) {
+    columns_ = indexes;
+    return *this;
+}
+
+Config& Config::column_names(const std::vector<std::string>& names) {
+    column_names_ = names;
+    return *this;
+}
+
+Config& Config::schema(const std::vector<csvkit_type_t>& types) {
+    schema_ = types;
+    return *this;
+}
+
+Config& Config::schema(const std::vector<ColumnInfo>& columns) {
+    schema_.clear();
+    for (const auto& column : columns) {
+        schema_.push_back(column.type);
+    }
+    return *this;
+}
+
 const csvkit_config_t& Config::get() const {
+    column_name_ptrs_.clear();
+    for (const auto& name : column_names_) {
+        column_name_ptrs_.push_back(name.c_str());
+    }
+
+    config_.columns = columns_.empty() ? nullptr : columns_.data();
+    config_.column_count = columns_.size();
+    config_.column_names = column_name_ptrs_.empty() ? nullptr : column_name_ptrs_.data();
+    config_.column_name_count = column_name_ptrs_.size();
+    config_.schema = schema_.empty() ? nullptr : schema_.data();
+    config_.schema_count = schema_.size();
     return config_;
 }
 
@@ -77,6 +163,8 @@ const csvkit_config_t& Config::get() const {
 // Row
 // ============================================================================
 
+Row::Row() : row_(nullptr), row_number_(0) {}
+
 Row::Row(csvkit_row_t* row) : row_(nullptr), row_number_(0) {
     if (!row) {
         throw Exception("Null row pointer");
@@ -106,7 +194,8 @@ Row::~Row() {
 }
 
 Row::Row(Row&& other) noexcept
-    : row_(other.row_), fields_(std::move(other.fields_)), row_number_(other.row_number_) {
+    : row_(other.row_), fields_(std::move(other.fields_)), row_number_(other.row_number_),
+      header_(std::move(other.header_)) {
     other.row_ = nullptr;
     other.row_number_ = 0;
 }
@@ -119,17 +208,37 @@ Row& Row::operator=(Row&& other) noexcept {
         row_ = other.row_;
         fields_ = std::move(other.fields_);
         row_number_ = other.row_number_;
+        header_ = std::move(other.header_);
         other.row_ = nullptr;
         other.row_number_ = 0;
     }
     return *this;
 }
 
+void Row::assign(const csvkit_row_view_t& view) {
+    row_number_ = view.row_number;
+    fields_.resize(view.field_count);
+    for (size_t i = 0; i < view.field_count; ++i) {
+        fields_[i].assign(view.fields[i].data, view.fields[i].len);
+    }
+}
+
 const std::string& Row::operator[](size_t index) const {
     // No bounds checking - follows STL convention for operator[]
     return fields_[index];
 }
 
+const std::string& Row::by_name(const char* name, size_t len) const {
+    size_t index = csvkit_header_find(header_.get(), name, len);
+    if (index == CSVKIT_NO_COLUMN) {
+        throw Exception("No column named " + std::string(name, len));
+    }
+    if (index >= fields_.size()) {
+        throw Exception("Row has no field for column " + std::string(name, len));
+    }
+    return fields_[index];
+}
+
 const std::string& Row::at(size_t index) const {
     if (index >= fields_.size()) {
         throw std::out_of_range("Field index out of range");
@@ -137,6 +246,51 @@ const std::string& Row::at(size_t index) const {
     return fields_[index];
 }
 
+int64_t Row::get_int64(size_t index) const {
+    const std::string& field = at(index);
+    int64_t value;
+    if (csvkit_parse_int64(field.data(), field.size(), &value) != CSVKIT_OK) {
+        throw Exception("Invalid int64 value: " + field);
+    }
+    return value;
+}
+
+double Row::get_double(size_t index) const {
+    const std::string& field = at(index);
+    double value;
+    if (csvkit_parse_double(field.data(), field.size(), &value) != CSVKIT_OK) {
+        throw Exception("Invalid double value: " + field);
+    }
+    return value;
+}
+
+bool Row::get_bool(size_t index) const {
+    const std::string& field = at(index);
+    bool value;
+    if (csvkit_parse_bool(field.data(), field.size(), &value) != CSVKIT_OK) {
+        throw Exception("Invalid bool value: " + field);
+    }
+    return value;
+}
+
+int32_t Row::get_date(size_t index) const {
+    const std::string& field = at(index);
+    int32_t value;
+    if (csvkit_parse_date(field.data(), field.size(), &value) != CSVKIT_OK) {
+        throw Exception("Invalid date value: " + field);
+    }
+    return value;
+}
+
+int64_t Row::get_timestamp(size_t index) const {
+    const std::string& field = at(index);
+    int64_t value;
+    if (csvkit_parse_timestamp(field.data(), field.size(), &value) != CSVKIT_OK) {
+        throw Exception("Invalid timestamp value: " + field);
+    }
+    return value;
+}
+
 size_t Row::size() const {
     return fields_.size();
 }
@@ -165,10 +319,166 @@ const std::vector<std::string>& Row::fields() const {
     return fields_;
 }
 
+// ============================================================================
+// Batch
+// ============================================================================
+
+Batch::Batch() {
+    csvkit_batch_init(&batch_);
+}
+
+Batch::~Batch() {
+    csvkit_batch_release(&batch_);
+}
+
+Batch::Batch(Batch&& other) noexcept : batch_(other.batch_) {
+    csvkit_batch_init(&other.batch_);
+}
+
+Batch& Batch::operator=(Batch&& other) noexcept {
+    if (this != &other) {
+        csvkit_batch_release(&batch_);
+        batch_ = other.batch_;
+        csvkit_batch_init(&other.batch_);
+    }
+    return *this;
+}
+
+size_t Batch::rows() const {
+    return batch_.row_count;
+}
+
+size_t Batch::columns() const {
+    return batch_.column_count;
+}
+
+csvkit_type_t Batch::type(size_t column) const {
+    return this->column(column).type;
+}
+
+const csvkit_column_t& Batch::cell(size_t column, size_t row, csvkit_type_t type) const {
+    const csvkit_column_t& col = this->column(column);
+    if (row >= batch_.row_count) {
+        throw Exception("Row index out of range");
+    }
+    if (col.type != type) {
+        throw Exception("Column has a different type");
+    }
+    return col;
+}
+
+std::string Batch::value(size_t column, size_t row) const {
+    const csvkit_column_t& col = cell(column, row, CSVKIT_TYPE_STRING);
+    return std::string(col.data + col.offsets[row],
+                       static_cast<size_t>(col.offsets[row + 1] - col.offsets[row]));
+}
+
+bool Batch::is_null(size_t column, size_t row) const {
+    const csvkit_column_t& col = this->column(column);
+    if (row >= batch_.row_count) {
+        throw Exception("Row index out of range");
+    }
+    return !((col.validity[row >> 3] >> (row & 7)) & 1);
+}
+
+int64_t Batch::int64_value(size_t column, size_t row) const {
+    bool timestamp = this->column(column).type == CSVKIT_TYPE_TIMESTAMP;
+    const csvkit_column_t& col = cell(column, row, timestamp ? CSVKIT_TYPE_TIMESTAMP : CSVKIT_TYPE_INT64);
+    int64_t value;
+    std::memcpy(&value, col.data + row * sizeof(int64_t), sizeof(value));
+    return value;
+}
+
+double Batch::double_value(size_t column, size_t row) const {
+    const csvkit_column_t& col = cell(column, row, CSVKIT_TYPE_DOUBLE);
+    double value;
+    std::memcpy(&value, col.data + row * sizeof(double), sizeof(value));
+    return value;
+}
+
+bool Batch::bool_value(size_t column, size_t row) const {
+    const csvkit_column_t& col = cell(column, row, CSVKIT_TYPE_BOOL);
+    return (static_cast<unsigned char>(col.data[row >> 3]) >> (row & 7)) & 1;
+}
+
+int32_t Batch::date_value(size_t column, size_t row) const {
+    const csvkit_column_t& col = cell(column, row, CSVKIT_TYPE_DATE);
+    int32_t value;
+    std::memcpy(&value, col.data + row * sizeof(int32_t), sizeof(value));
+    return value;
+}
+
+const csvkit_column_t& Batch::column(size_t index) const {
+    if (index >= batch_.column_count) {
+        throw Exception("Column index out of range");
+    }
+    return batch_.columns[index];
+}
+
+csvkit_batch_t* Batch::get() {
+    return &batch_;
+}
+
+const csvkit_batch_t* Batch::get() const {
+    return &batch_;
+}
+
 // ============================================================================
 // Parser
 // ============================================================================
 
+// Rows of a push source are built here, where the C callback can reach them
+struct Parser::PushState {
+    std::function<void(const Row&)> on_row;
+    csvkit_parser_t* parser;
+    Row row;
+    std::exception_ptr error;  // Thrown by on_row, rethrown by feed()
+};
+
+// Callbacks of Parser::parse(), reached through csvkit_callbacks_t::user_data
+struct ParseVisitor {
+    std::function<void(const char*, size_t, size_t)> on_field;
+    std::function<void(size_t)> on_row_end;
+    std::exception_ptr error;
+};
+
+// Exceptions must not unwind through the C parser
+static csvkit_error_t visit_field(const char* data, size_t len, size_t column, void* user_data) {
+    ParseVisitor* visitor = static_cast<ParseVisitor*>(user_data);
+    try {
+        visitor->on_field(data, len, column);
+    } catch (...) {
+        visitor->error = std::current_exception();
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+    return CSVKIT_OK;
+}
+
+static csvkit_error_t visit_row_end(size_t row_number, void* user_data) {
+    ParseVisitor* visitor = static_cast<ParseVisitor*>(user_data);
+    try {
+        visitor->on_row_end(row_number);
+    } catch (...) {
+        visitor->error = std::current_exception();
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+    return CSVKIT_OK;
+}
+
+// Copy of the parser's header that rows can share, or null without one
+static std::shared_ptr<const csvkit_header_t> copy_header(csvkit_parser_t* parser) {
+    const csvkit_header_t* header = csvkit_get_header(parser);
+    if (!header) {
+        return nullptr;
+    }
+
+    csvkit_header_t* copy = csvkit_header_copy(header);
+    if (!copy) {
+        throw Exception("Out of memory");
+    }
+    return std::shared_ptr<const csvkit_header_t>(copy, csvkit_header_free);
+}
+
 Parser::Parser() : parser_(csvkit_parser_new()) {
     if (!parser_) {
         throw Exception("Failed to create parser");
@@ -188,7 +498,8 @@ Parser::~Parser() {
     }
 }
 
-Parser::Parser(Parser&& other) noexcept : parser_(other.parser_) {
+Parser::Parser(Parser&& other) noexcept
+    : parser_(other.parser_), header_(std::move(other.header_)), push_(std::move(other.push_)) {
     other.parser_ = nullptr;
 }
 
@@ -198,19 +509,31 @@ Parser& Parser::operator=(Parser&& other) noexcept {
             csvkit_parser_free(parser_);
         }
         parser_ = other.parser_;
+        header_ = std::move(other.header_);
+        push_ = std::move(other.push_);
         other.parser_ = nullptr;
     }
     return *this;
 }
 
 void Parser::open(const std::string& filename) {
+    header_.reset();
     csvkit_error_t err = csvkit_open_file(parser_, filename.c_str());
     if (err != CSVKIT_OK) {
         throw Exception(get_error_message());
     }
 }
 
+void Parser::open_mmap(const std::string& filename) {
+    header_.reset();
+    csvkit_error_t err = csvkit_open_mmap(parser_, filename.c_str());
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
 void Parser::open(FILE* stream) {
+    header_.reset();
     csvkit_error_t err = csvkit_open_stream(parser_, stream);
     if (err != CSVKIT_OK) {
         throw Exception(get_error_message());
@@ -218,12 +541,67 @@ void Parser::open(FILE* stream) {
 }
 
 void Parser::open_string(const std::string& data) {
+    header_.reset();
     csvkit_error_t err = csvkit_open_string(parser_, data.c_str(), data.size());
     if (err != CSVKIT_OK) {
         throw Exception(get_error_message());
     }
 }
 
+void Parser::open_push(std::function<void(const Row&)> on_row) {
+    std::unique_ptr<PushState> state(new PushState());
+    state->on_row = std::move(on_row);
+    state->parser = parser_;
+
+    header_.reset();
+    csvkit_error_t err = csvkit_open_push(parser_, &Parser::push_row, state.get());
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+    push_ = std::move(state);
+}
+
+void Parser::feed(const char* data, size_t len) {
+    check_feed(csvkit_feed(parser_, data, len));
+}
+
+void Parser::feed(const std::string& data) {
+    feed(data.data(), data.size());
+}
+
+void Parser::feed_end() {
+    check_feed(csvkit_feed_end(parser_));
+}
+
+csvkit_error_t Parser::push_row(const csvkit_row_view_t* view, void* user_data) {
+    PushState* state = static_cast<PushState*>(user_data);
+
+    // Exceptions must not unwind through the C parser
+    try {
+        state->row.assign(*view);
+        if (!state->row.header_) {
+            state->row.header_ = copy_header(state->parser);
+        }
+        state->on_row(state->row);
+    } catch (...) {
+        state->error = std::current_exception();
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+    return CSVKIT_OK;
+}
+
+void Parser::check_feed(csvkit_error_t err) {
+    if (push_ && push_->error) {
+        std::exception_ptr error = push_->error;
+        push_->error = nullptr;
+        std::rethrow_exception(error);
+    }
+
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
 std::unique_ptr<Row> Parser::read_row() {
     csvkit_row_t* row = nullptr;
     csvkit_error_t err = csvkit_read_row(parser_, &row);
@@ -236,7 +614,81 @@ std::unique_ptr<Row> Parser::read_row() {
         throw Exception(get_error_message());
     }
 
-    return std::unique_ptr<Row>(new Row(row));
+    std::unique_ptr<Row> result(new Row(row));
+    result->header_ = shared_header();
+    return result;
+}
+
+bool Parser::read_row(Row& row) {
+    csvkit_row_view_t view;
+    csvkit_error_t err = csvkit_read_row_view(parser_, &view);
+
+    if (err == CSVKIT_ERROR_EOF) {
+        return false;
+    }
+
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+
+    row.assign(view);
+    if (row.header_ != shared_header()) {
+        row.header_ = header_;
+    }
+    return true;
+}
+
+void Parser::build_row_index(const std::string& index_path, size_t interval) {
+    csvkit_error_t err = csvkit_build_row_index(parser_, index_path.c_str(), interval);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
+bool Parser::seek_row(const std::string& index_path, size_t row_number) {
+    csvkit_error_t err = csvkit_seek_row(parser_, index_path.c_str(), row_number);
+
+    if (err == CSVKIT_ERROR_EOF) {
+        return false;
+    }
+
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+
+    return true;
+}
+
+std::vector<ColumnInfo> Parser::infer_schema(size_t sample_rows, size_t sample_chunks) {
+    csvkit_infer_options_t options = {sample_rows, sample_chunks, 0};
+    csvkit_schema_t schema;
+
+    csvkit_error_t err = csvkit_infer_schema(parser_, &options, &schema);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+
+    std::vector<ColumnInfo> columns;
+    columns.reserve(schema.column_count);
+    for (size_t i = 0; i < schema.column_count; i++) {
+        columns.push_back(ColumnInfo{schema.types[i], schema.nullable[i]});
+    }
+    csvkit_schema_release(&schema);
+    return columns;
+}
+
+bool Parser::read_batch(Batch& batch, size_t max_rows) {
+    csvkit_error_t err = csvkit_read_batch(parser_, batch.get(), max_rows);
+
+    if (err == CSVKIT_ERROR_EOF) {
+        return false;
+    }
+
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+
+    return true;
 }
 
 std::vector<Row> Parser::read_all() {
@@ -247,8 +699,48 @@ std::vector<Row> Parser::read_all() {
     return rows;
 }
 
+std::vector<std::string> Parser::header() {
+    const csvkit_header_t* header = csvkit_get_header(parser_);
+
+    std::vector<std::string> names;
+    names.reserve(csvkit_header_count(header));
+    for (size_t i = 0; i < csvkit_header_count(header); i++) {
+        names.emplace_back(csvkit_header_name(header, i));
+    }
+    return names;
+}
+
+const std::shared_ptr<const csvkit_header_t>& Parser::shared_header() {
+    if (!header_) {
+        header_ = copy_header(parser_);
+    }
+    return header_;
+}
+
+void Parser::parse(std::function<void(const char*, size_t, size_t)> on_field,
+                   std::function<void(size_t)> on_row_end) {
+    ParseVisitor visitor;
+    visitor.on_field = std::move(on_field);
+    visitor.on_row_end = std::move(on_row_end);
+
+    csvkit_callbacks_t callbacks;
+    callbacks.on_field = visitor.on_field ? visit_field : nullptr;
+    callbacks.on_row_end = visitor.on_row_end ? visit_row_end : nullptr;
+    callbacks.user_data = &visitor;
+
+    csvkit_error_t err = csvkit_parse_with_callbacks(parser_, &callbacks);
+    if (visitor.error) {
+        std::rethrow_exception(visitor.error);
+    }
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
 void Parser::close() {
+    header_.reset();
     csvkit_close(parser_);
+    push_.reset();
 }
 
 std::string Parser::get_error_message() const {
@@ -335,7 +827,10 @@ Writer::~Writer() {
     }
 }
 
-Writer::Writer(Writer&& other) noexcept : writer_(other.writer_) {
+Writer::Writer(Writer&& other) noexcept
+    : writer_(other.writer_),
+      field_ptrs_(std::move(other.field_ptrs_)),
+      field_lens_(std::move(other.field_lens_)) {
     other.writer_ = nullptr;
 }
 
@@ -345,6 +840,8 @@ Writer& Writer::operator=(Writer&& other) noexcept {
             csvkit_writer_free(writer_);
         }
         writer_ = other.writer_;
+        field_ptrs_ = std::move(other.field_ptrs_);
+        field_lens_ = std::move(other.field_lens_);
         other.writer_ = nullptr;
     }
     return *this;
@@ -365,19 +862,14 @@ void Writer::open(FILE* stream) {
 }
 
 void Writer::write_row(const std::vector<std::string>& fields) {
-    std::vector<const char*> c_fields;
-    c_fields.reserve(fields.size());
+    field_ptrs_.clear();
+    field_lens_.clear();
     for (const auto& field : fields) {
-        c_fields.push_back(field.c_str());
+        field_ptrs_.push_back(field.data());
+        field_lens_.push_back(field.size());
     }
 
-    csvkit_error_t err = csvkit_writer_write_row(
-        writer_, c_fields.data(), c_fields.size()
-    );
-
-    if (err != CSVKIT_OK) {
-        throw Exception(get_error_message());
-    }
+    write_row(field_ptrs_.data(), field_lens_.data(), field_ptrs_.size());
 }
 
 void Writer::write_row(std::initializer_list<std::string> fields) {
@@ -391,8 +883,88 @@ void Writer::write_row(const char** fields, size_t count) {
     }
 }
 
+void Writer::write_row(const char** fields, const size_t* lengths, size_t count) {
+    csvkit_error_t err = csvkit_writer_write_row_n(writer_, fields, lengths, count);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
+
+void Writer::write_rows(const char** fields, const size_t* lengths, size_t rows, size_t columns,
+                        csvkit_layout_t layout) {
+    csvkit_error_t err = csvkit_writer_write_rows(writer_, fields, lengths, rows, columns, layout);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
+void Writer::write_batch(const Batch& batch) {
+    write_batch(*batch.get());
+}
+
+void Writer::write_batch(const csvkit_batch_t& batch) {
+    csvkit_error_t err = csvkit_writer_write_batch(writer_, &batch);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
+void Writer::write_field(const char* field) {
+    write_field(field, field ? std::strlen(field) : 0);
+}
+
+void Writer::write_field(const char* data, size_t len) {
+    csvkit_error_t err = csvkit_writer_write_field(writer_, data, len);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
+void Writer::write_field(const std::string& field) {
+    write_field(field.data(), field.size());
+}
+
+void Writer::write_int64(int64_t value) {
+    csvkit_error_t err = csvkit_writer_write_int64(writer_, value);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
+void Writer::write_double(double value) {
+    csvkit_error_t err = csvkit_writer_write_double(writer_, value);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
+void Writer::write_bool(bool value) {
+    csvkit_error_t err = csvkit_writer_write_bool(writer_, value);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
+void Writer::end_row() {
+    csvkit_error_t err = csvkit_writer_end_row(writer_);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
+void Writer::flush() {
+    csvkit_error_t err = csvkit_writer_flush(writer_);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
+}
+
 void Writer::close() {
-    csvkit_writer_close(writer_);
+    csvkit_error_t err = csvkit_writer_close(writer_);
+    if (err != CSVKIT_OK) {
+        throw Exception(get_error_message());
+    }
 }
 
 std::string Writer::get_error_message() const {
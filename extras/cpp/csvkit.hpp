@@ -25,6 +25,10 @@
 #include <vector>
 #include <stdexcept>
 #include <memory>
+#include <functional>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 namespace csvkit {
 
@@ -40,6 +44,14 @@ private:
     static std::string error_to_string(csvkit_error_t err);
 };
 
+/**
+ * Column type found by Parser::infer_schema()
+ */
+struct ColumnInfo {
+    csvkit_type_t type;
+    bool nullable;  // Empty or missing fields were seen
+};
+
 /**
  * Configuration for CSV parsing/writing
  */
@@ -53,11 +65,36 @@ public:
     Config& trim_whitespace(bool trim);
     Config& skip_empty_rows(bool skip);
     Config& strict_mode(bool strict);
+    Config& buffer_size(size_t size);
+    Config& use_mmap(bool enable);
+    Config& structural_index(bool enable);
+    Config& threads(unsigned count);
+    Config& read_ahead(unsigned buffers);
+    Config& direct_io(bool enable);
+    Config& decompress(bool enable);
+    Config& has_header(bool header);
+
+    // Writer output compression (level 0 = the format's default)
+    Config& compression(csvkit_compression_t format, int level = 0);
+    Config& compression_threads(unsigned count);
+
+    // Keep only these columns, in this order (empty = all columns)
+    Config& columns(const std::vector<size_t>& indexes);
+    Config& column_names(const std::vector<std::string>& names);
+
+    // Column types for typed reads and batches (missing = string)
+    Config& schema(const std::vector<csvkit_type_t>& types);
+    Config& schema(const std::vector<ColumnInfo>& columns);
 
     const csvkit_config_t& get() const;
 
 private:
-    csvkit_config_t config_;
+    // get() points config_ at these, so copies of a Config stay valid
+    mutable csvkit_config_t config_;
+    std::vector<size_t> columns_;
+    std::vector<std::string> column_names_;
+    mutable std::vector<const char*> column_name_ptrs_;
+    std::vector<csvkit_type_t> schema_;
 };
 
 /**
@@ -65,6 +102,7 @@ private:
  */
 class Row {
 public:
+    Row();
     explicit Row(csvkit_row_t* row);
     ~Row();
 
@@ -78,6 +116,22 @@ public:
     const std::string& operator[](size_t index) const;
     const std::string& at(size_t index) const;
 
+    // Access fields by header name (Config::has_header); throws Exception
+    // if there is no such column or the row is shorter
+#if __cplusplus >= 201703L
+    const std::string& operator[](std::string_view name) const;
+#else
+    const std::string& operator[](const std::string& name) const;
+#endif
+    const std::string& by_name(const char* name, size_t len) const;
+
+    // Convert a field; throws Exception if it is not a valid value
+    int64_t get_int64(size_t index) const;
+    double get_double(size_t index) const;
+    bool get_bool(size_t index) const;
+    int32_t get_date(size_t index) const;        // Days since 1970-01-01
+    int64_t get_timestamp(size_t index) const;   // Microseconds since 1970-01-01 UTC
+
     size_t size() const;
     size_t field_count() const;
     size_t row_number() const;
@@ -91,9 +145,58 @@ public:
     const std::vector<std::string>& fields() const;
 
 private:
+    friend class Parser;
+
+    // Refill from a row view, reusing existing string capacity
+    void assign(const csvkit_row_view_t& view);
+
     csvkit_row_t* row_;
     std::vector<std::string> fields_;
     size_t row_number_;
+    std::shared_ptr<const csvkit_header_t> header_;  // Shared by the parser's rows
+};
+
+/**
+ * Rows stored column by column, filled by Parser::read_batch()
+ */
+class Batch {
+public:
+    Batch();
+    ~Batch();
+
+    Batch(const Batch&) = delete;
+    Batch& operator=(const Batch&) = delete;
+
+    Batch(Batch&& other) noexcept;
+    Batch& operator=(Batch&& other) noexcept;
+
+    size_t rows() const;
+    size_t columns() const;
+
+    csvkit_type_t type(size_t column) const;
+
+    // Field value of a string column; empty if the row has no value
+    std::string value(size_t column, size_t row) const;
+    bool is_null(size_t column, size_t row) const;
+
+    // Values of typed columns (int64_value() also reads timestamps)
+    int64_t int64_value(size_t column, size_t row) const;
+    double double_value(size_t column, size_t row) const;
+    bool bool_value(size_t column, size_t row) const;
+    int32_t date_value(size_t column, size_t row) const;
+
+    // Arrow-compatible buffers of a column
+    const csvkit_column_t& column(size_t index) const;
+
+    // Get underlying C batch
+    csvkit_batch_t* get();
+    const csvkit_batch_t* get() const;
+
+private:
+    // Column of a cell, checking the indexes and the column type
+    const csvkit_column_t& cell(size_t column, size_t row, csvkit_type_t type) const;
+
+    csvkit_batch_t batch_;
 };
 
 /**
@@ -114,18 +217,63 @@ public:
     // Open CSV from file
     void open(const std::string& filename);
 
+    // Open CSV file through a read-only memory mapping
+    void open_mmap(const std::string& filename);
+
     // Open CSV from FILE* stream
     void open(FILE* stream);
 
     // Open CSV from string
     void open_string(const std::string& data);
 
+    // Parse chunks passed to feed(), calling on_row for every complete row.
+    // Exceptions thrown by on_row propagate out of feed() and feed_end().
+    void open_push(std::function<void(const Row&)> on_row);
+
+    // Append a chunk of input to a push source
+    void feed(const char* data, size_t len);
+    void feed(const std::string& data);
+
+    // End the input of a push source, parsing the last row
+    void feed_end();
+
     // Read next row
     std::unique_ptr<Row> read_row();
 
+    // Read next row into an existing Row, reusing its storage.
+    // Returns false at end of input.
+    bool read_row(Row& row);
+
+    // Read up to max_rows rows into a columnar batch.
+    // Returns false at end of input.
+    bool read_batch(Batch& batch, size_t max_rows);
+
     // Read all rows
     std::vector<Row> read_all();
 
+    // Parse the rest of the input without building rows: on_field gets each
+    // field's bytes (valid during the call) and its column, on_row_end the
+    // row number. Exceptions thrown by either stop parsing and propagate.
+    void parse(std::function<void(const char* data, size_t len, size_t column)> on_field,
+               std::function<void(size_t row_number)> on_row_end = nullptr);
+
+    // Write a row offset index for the current file or string source,
+    // then rewind to the first row
+    void build_row_index(const std::string& index_path, size_t interval);
+
+    // Make row_number (1-based) the next row read, using an index from
+    // build_row_index(). Returns false if the source has fewer rows.
+    bool seek_row(const std::string& index_path, size_t row_number);
+
+    // Infer column types from the first sample_rows rows (0 = 1000) and
+    // sample_chunks samples spread over the rest of a file or string source,
+    // then rewind to the first row
+    std::vector<ColumnInfo> infer_schema(size_t sample_rows = 0, size_t sample_chunks = 0);
+
+    // Names of the returned columns (Config::has_header), reading the
+    // header if no row has been read yet. Empty without a header.
+    std::vector<std::string> header();
+
     // Close current source
     void close();
 
@@ -161,7 +309,17 @@ public:
     Iterator end();
 
 private:
+    struct PushState;
+
+    // Header of the current source, copied once for all rows
+    const std::shared_ptr<const csvkit_header_t>& shared_header();
+
+    static csvkit_error_t push_row(const csvkit_row_view_t* view, void* user_data);
+    void check_feed(csvkit_error_t err);
+
     csvkit_parser_t* parser_;
+    std::shared_ptr<const csvkit_header_t> header_;
+    std::unique_ptr<PushState> push_;  // Heap-allocated so moves keep the callback's pointer valid
 };
 
 /**
@@ -194,6 +352,34 @@ public:
     // Write a row from C-style array
     void write_row(const char** fields, size_t count);
 
+    // Write a row from C-style arrays of fields and their lengths
+    void write_row(const char** fields, const size_t* lengths, size_t count);
+
+#if __cplusplus >= 201703L
+    // Write a row of string views, which need no NUL terminators
+    void write_row(const std::vector<std::string_view>& fields);
+#endif
+
+    // Write a table of fields (lengths may be nullptr for C-strings)
+    void write_rows(const char** fields, const size_t* lengths, size_t rows, size_t columns,
+                    csvkit_layout_t layout = CSVKIT_ROW_MAJOR);
+
+    // Write the rows of a columnar batch, formatting typed values directly
+    void write_batch(const Batch& batch);
+    void write_batch(const csvkit_batch_t& batch);
+
+    // Build a row one field at a time, then end it with end_row()
+    void write_field(const char* field);
+    void write_field(const char* data, size_t len);
+    void write_field(const std::string& field);
+    void write_int64(int64_t value);
+    void write_double(double value);
+    void write_bool(bool value);
+    void end_row();
+
+    // Write out buffered rows and flush the stream
+    void flush();
+
     // Close writer
     void close();
 
@@ -202,8 +388,35 @@ public:
 
 private:
     csvkit_writer_t* writer_;
+    // Field pointers and lengths, reused from row to row
+    std::vector<const char*> field_ptrs_;
+    std::vector<size_t> field_lens_;
 };
 
+// The overloads below depend on the -std of the code that includes this
+// header, so they are inline and the library only exports what they call
+
+#if __cplusplus >= 201703L
+inline const std::string& Row::operator[](std::string_view name) const {
+    return by_name(name.data(), name.size());
+}
+
+inline void Writer::write_row(const std::vector<std::string_view>& fields) {
+    field_ptrs_.clear();
+    field_lens_.clear();
+    for (const auto& field : fields) {
+        field_ptrs_.push_back(field.data());
+        field_lens_.push_back(field.size());
+    }
+
+    write_row(field_ptrs_.data(), field_lens_.data(), field_ptrs_.size());
+}
+#else
+inline const std::string& Row::operator[](const std::string& name) const {
+    return by_name(name.data(), name.size());
+}
+#endif
+
 // Helper functions
 std::vector<Row> read_file(const std::string& filename, const Config& config = Config());
 std::vector<Row> read_string(const std::string& data, const Config& config = Config());
@@ -21,6 +21,7 @@
 #define CSVKIT_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
 
@@ -30,9 +31,26 @@ extern "C" {
 
 /* Version information */
 #define CSVKIT_VERSION_MAJOR 0
-#define CSVKIT_VERSION_MINOR 1
+#define CSVKIT_VERSION_MINOR 2
 #define CSVKIT_VERSION_PATCH 0
 
+/* Field types for typed parsing */
+typedef enum {
+    CSVKIT_TYPE_STRING = 0,
+    CSVKIT_TYPE_INT64,      /* Signed 64-bit integer */
+    CSVKIT_TYPE_DOUBLE,     /* IEEE double */
+    CSVKIT_TYPE_BOOL,       /* true/false (any case) or 1/0 */
+    CSVKIT_TYPE_DATE,       /* YYYY-MM-DD, as days since 1970-01-01 */
+    CSVKIT_TYPE_TIMESTAMP   /* ISO 8601, as microseconds since 1970-01-01 UTC */
+} csvkit_type_t;
+
+/* Compression formats */
+typedef enum {
+    CSVKIT_COMPRESSION_NONE = 0,
+    CSVKIT_COMPRESSION_GZIP,
+    CSVKIT_COMPRESSION_ZSTD
+} csvkit_compression_t;
+
 /* CSV parser configuration */
 typedef struct {
     char delimiter;          /* Field delimiter (default: ',') */
@@ -41,6 +59,30 @@ typedef struct {
     bool trim_whitespace;   /* Trim leading/trailing whitespace */
     bool skip_empty_rows;   /* Skip rows with no data */
     bool strict_mode;       /* Strict RFC 4180 compliance */
+    size_t buffer_size;     /* Input buffer size in bytes (0 = default 256 KiB) */
+    bool use_mmap;          /* Memory-map regular files in csvkit_open_file() */
+    bool structural_index;  /* Two-stage indexed parsing of in-memory sources */
+    unsigned threads;       /* Parser threads for in-memory sources (0 or 1 = single) */
+    unsigned read_ahead;    /* Buffers read ahead of the parser for file and
+                             * stream sources (0 = off, at least 2 are used) */
+    bool direct_io;         /* Read ahead from regular files with O_DIRECT */
+    bool decompress;        /* Decompress gzip and zstd file and stream sources */
+    csvkit_compression_t compression;  /* Writer output compression */
+    int compression_level;  /* Writer compression level (0 = format default) */
+    unsigned compression_threads;  /* zstd worker threads for the writer (0 = none) */
+    bool has_header;        /* First row is a header, not returned as data */
+
+    /* Column projection: rows hold only these columns, in this order.
+     * Use either indexes or header names (requires has_header). */
+    const size_t *columns;            /* Column indexes (NULL = all columns) */
+    size_t column_count;
+    const char *const *column_names;  /* Header names (NULL = all columns) */
+    size_t column_name_count;
+
+    /* Column types for csvkit_read_row_typed() and csvkit_read_batch(),
+     * indexed like the returned fields. Columns past schema_count are strings. */
+    const csvkit_type_t *schema;      /* NULL = all strings */
+    size_t schema_count;
 } csvkit_config_t;
 
 /* CSV row structure */
@@ -48,8 +90,46 @@ typedef struct {
     char **fields;          /* Array of field values */
     size_t field_count;     /* Number of fields */
     size_t row_number;      /* Row number in the file */
+
+    /* Storage reused by csvkit_read_row_into() (NULL for csvkit_read_row() rows) */
+    size_t fields_capacity; /* Allocated slots in fields */
+    char *data;             /* NUL-separated field bytes */
+    size_t data_capacity;   /* Allocated bytes in data */
 } csvkit_row_t;
 
+/* Borrowed field value: not NUL-terminated, may contain NUL bytes */
+typedef struct {
+    const char *data;       /* Start of field bytes */
+    size_t len;             /* Length of field in bytes */
+} csvkit_field_view_t;
+
+/* Row of borrowed fields, valid until the next read or close on the parser */
+typedef struct {
+    const csvkit_field_view_t *fields;  /* Array of field views */
+    size_t field_count;     /* Number of fields */
+    size_t row_number;      /* Row number in the file */
+} csvkit_row_view_t;
+
+/* Converted field of a typed row */
+typedef struct {
+    bool is_null;           /* Empty field in a non-string column */
+    union {
+        int64_t int64;
+        double float64;
+        bool boolean;
+        int32_t date;       /* Days since 1970-01-01 */
+        int64_t timestamp;  /* Microseconds since 1970-01-01 UTC */
+    } value;                /* Unset for string columns and nulls */
+} csvkit_value_t;
+
+/* Row read by csvkit_read_row_typed(), valid until the next read or close */
+typedef struct {
+    const csvkit_value_t *values;       /* Converted values */
+    const csvkit_field_view_t *fields;  /* Field bytes, for string columns */
+    size_t field_count;     /* Number of fields */
+    size_t row_number;      /* Row number in the file */
+} csvkit_typed_row_t;
+
 /* CSV parser handle */
 typedef struct csvkit_parser csvkit_parser_t;
 
@@ -82,18 +162,77 @@ void csvkit_parser_free(csvkit_parser_t *parser);
 /* Open a CSV file for parsing */
 csvkit_error_t csvkit_open_file(csvkit_parser_t *parser, const char *filename);
 
+/* Open a CSV file through a read-only memory mapping */
+csvkit_error_t csvkit_open_mmap(csvkit_parser_t *parser, const char *filename);
+
 /* Open a CSV from FILE* stream */
 csvkit_error_t csvkit_open_stream(csvkit_parser_t *parser, FILE *stream);
 
 /* Parse from a string buffer */
 csvkit_error_t csvkit_open_string(csvkit_parser_t *parser, const char *data, size_t len);
 
+/* Called for each row of a push source. The view is valid until the
+ * callback returns. Returning anything but CSVKIT_OK stops parsing, and
+ * csvkit_feed() or csvkit_feed_end() return that value. */
+typedef csvkit_error_t (*csvkit_row_callback_t)(const csvkit_row_view_t *row, void *user_data);
+
+/* Parse bytes pushed with csvkit_feed(), passing complete rows to callback.
+ * With a NULL callback, rows are read with csvkit_read_row() and the like. */
+csvkit_error_t csvkit_open_push(csvkit_parser_t *parser, csvkit_row_callback_t callback,
+                                void *user_data);
+
+/* Append a chunk of input to a push source and parse the rows it completes */
+csvkit_error_t csvkit_feed(csvkit_parser_t *parser, const char *data, size_t len);
+
+/* End the input of a push source and parse the last row */
+csvkit_error_t csvkit_feed_end(csvkit_parser_t *parser);
+
 /* Read the next row from the CSV */
 csvkit_error_t csvkit_read_row(csvkit_parser_t *parser, csvkit_row_t **row);
 
+/* Read the next row as views into the parser's buffers (no allocation) */
+csvkit_error_t csvkit_read_row_view(csvkit_parser_t *parser, csvkit_row_view_t *view);
+
+/* Functions called by csvkit_parse_with_callbacks(); either may be NULL.
+ * Returning anything but CSVKIT_OK stops parsing. */
+typedef struct {
+    /* A field of the current row: not NUL-terminated, valid until the
+     * callback returns. column is the index among the returned fields. */
+    csvkit_error_t (*on_field)(const char *data, size_t len, size_t column, void *user_data);
+    /* The row's fields have all been passed to on_field */
+    csvkit_error_t (*on_row_end)(size_t row_number, void *user_data);
+    void *user_data;
+} csvkit_callbacks_t;
+
+/* Parse the rest of the input, passing fields straight from the parser's
+ * buffers to the callbacks instead of building rows */
+csvkit_error_t csvkit_parse_with_callbacks(csvkit_parser_t *parser, const csvkit_callbacks_t *callbacks);
+
+/* Read the next row, converting fields to the types of config.schema */
+csvkit_error_t csvkit_read_row_typed(csvkit_parser_t *parser, csvkit_typed_row_t *row);
+
+/* Initialize a caller-owned row for csvkit_read_row_into() */
+void csvkit_row_init(csvkit_row_t *row);
+
+/* Read the next row into a caller-owned row, reusing its storage */
+csvkit_error_t csvkit_read_row_into(csvkit_parser_t *parser, csvkit_row_t *row);
+
+/* Release the storage of a row initialized with csvkit_row_init() */
+void csvkit_row_release(csvkit_row_t *row);
+
 /* Free a row structure */
 void csvkit_row_free(csvkit_row_t *row);
 
+/* Record the offset of every `interval`-th row of a file or string source
+ * in a sidecar index file, then rewind to the first row */
+csvkit_error_t csvkit_build_row_index(csvkit_parser_t *parser, const char *index_path,
+                                      size_t interval);
+
+/* Position the parser so that the next row read is `row_number` (1-based),
+ * using an index written by csvkit_build_row_index() */
+csvkit_error_t csvkit_seek_row(csvkit_parser_t *parser, const char *index_path,
+                               size_t row_number);
+
 /* Close the current CSV source */
 void csvkit_close(csvkit_parser_t *parser);
 
@@ -113,6 +252,145 @@ size_t csvkit_row_field_count(const csvkit_row_t *row);
 /* Check if a row is empty */
 bool csvkit_row_is_empty(const csvkit_row_t *row);
 
+/* Convert a field (CSVKIT_ERROR_PARSE if it is not a valid value) */
+csvkit_error_t csvkit_row_get_int64(const csvkit_row_t *row, size_t index, int64_t *value);
+csvkit_error_t csvkit_row_get_double(const csvkit_row_t *row, size_t index, double *value);
+csvkit_error_t csvkit_row_get_bool(const csvkit_row_t *row, size_t index, bool *value);
+csvkit_error_t csvkit_row_get_date(const csvkit_row_t *row, size_t index, int32_t *value);
+csvkit_error_t csvkit_row_get_timestamp(const csvkit_row_t *row, size_t index, int64_t *value);
+
+/*
+ * Header API
+ */
+
+/* Column names of a header row, hashed for lookup by name */
+typedef struct csvkit_header csvkit_header_t;
+
+/* Column index of a name that is not in the header */
+#define CSVKIT_NO_COLUMN ((size_t)-1)
+
+/* Header of the current source (config.has_header), read now if no row
+ * has been read yet. Names are those of the returned columns. NULL without
+ * a header or if it cannot be read. Valid until the header is read again
+ * (new source or rewind) or the parser is freed. */
+const csvkit_header_t *csvkit_get_header(csvkit_parser_t *parser);
+
+/* Copy a header so that it outlives its parser */
+csvkit_header_t *csvkit_header_copy(const csvkit_header_t *header);
+
+/* Free a header returned by csvkit_header_copy() */
+void csvkit_header_free(csvkit_header_t *header);
+
+/* Number of columns in the header */
+size_t csvkit_header_count(const csvkit_header_t *header);
+
+/* Name of a column (returns NULL if out of bounds) */
+const char *csvkit_header_name(const csvkit_header_t *header, size_t index);
+
+/* Index of the first column named `name` (len bytes), or CSVKIT_NO_COLUMN */
+size_t csvkit_header_find(const csvkit_header_t *header, const char *name, size_t len);
+
+/* Get field value by column name (returns NULL if there is no such column
+ * or the row is shorter) */
+const char *csvkit_row_get_field_by_name(const csvkit_row_t *row, const csvkit_header_t *header,
+                                         const char *name);
+
+/*
+ * Conversion Functions
+ *
+ * Locale-independent conversions of a whole field. Surrounding whitespace
+ * is not accepted. Return CSVKIT_ERROR_PARSE for malformed or out of range
+ * values.
+ */
+
+/* Decimal integer with optional sign */
+csvkit_error_t csvkit_parse_int64(const char *data, size_t len, int64_t *value);
+
+/* Decimal floating point with optional exponent, inf, infinity or nan.
+ * Correctly rounded. */
+csvkit_error_t csvkit_parse_double(const char *data, size_t len, double *value);
+
+/* true or false in any case, 1 or 0 */
+csvkit_error_t csvkit_parse_bool(const char *data, size_t len, bool *value);
+
+/* YYYY-MM-DD, as days since 1970-01-01 */
+csvkit_error_t csvkit_parse_date(const char *data, size_t len, int32_t *days);
+
+/* YYYY-MM-DD[(T| )HH:MM[:SS[.fraction]][Z|(+|-)HH[[:]MM]]], as microseconds
+ * since 1970-01-01 UTC. Times without an offset are taken as UTC. */
+csvkit_error_t csvkit_parse_timestamp(const char *data, size_t len, int64_t *micros);
+
+/*
+ * Schema Inference
+ */
+
+/* Sampling options for csvkit_infer_schema() */
+typedef struct {
+    size_t sample_rows;     /* Rows read from the start (0 = 1000) */
+    size_t sample_chunks;   /* Extra samples spread over the rest of the input */
+    size_t chunk_rows;      /* Rows per extra sample (0 = 100) */
+} csvkit_infer_options_t;
+
+/* Inferred column types, usable as config.schema */
+typedef struct {
+    csvkit_type_t *types;   /* Type of each column */
+    bool *nullable;         /* Column had empty or missing fields */
+    size_t column_count;
+    size_t rows_sampled;
+} csvkit_schema_t;
+
+/* Infer column types by sampling a file or string source, then rewind it
+ * to the first row. options may be NULL for the defaults. */
+csvkit_error_t csvkit_infer_schema(csvkit_parser_t *parser, const csvkit_infer_options_t *options,
+                                   csvkit_schema_t *schema);
+
+/* Free the arrays of an inferred schema */
+void csvkit_schema_release(csvkit_schema_t *schema);
+
+/*
+ * Columnar Batch API
+ */
+
+/* One column of a batch, laid out as an Arrow array: large string for
+ * string columns, a primitive array for typed columns */
+typedef struct {
+    csvkit_type_t type;     /* From config.schema */
+    uint8_t *validity;      /* Bit i (LSB first) set if row i has a value */
+    int64_t *offsets;       /* String columns: row_count + 1 offsets into data */
+    char *data;             /* Field bytes back to back, or fixed-width values
+                             * (int64_t, double, int32_t days, bits for bool) */
+    size_t null_count;      /* Rows without a value */
+
+    size_t data_capacity;   /* Allocated bytes in data */
+    size_t row_capacity;    /* Rows that validity and offsets can hold */
+} csvkit_column_t;
+
+/* Rows read by csvkit_read_batch(), stored column by column */
+typedef struct {
+    csvkit_column_t *columns;
+    size_t column_count;
+    size_t row_count;
+    size_t column_capacity; /* Allocated entries in columns */
+} csvkit_batch_t;
+
+/* Arrow C Data Interface structures (see arrow/c/abi.h) */
+struct ArrowSchema;
+struct ArrowArray;
+
+/* Initialize a caller-owned batch for csvkit_read_batch() */
+void csvkit_batch_init(csvkit_batch_t *batch);
+
+/* Read up to max_rows rows into the batch, replacing its contents */
+csvkit_error_t csvkit_read_batch(csvkit_parser_t *parser, csvkit_batch_t *batch, size_t max_rows);
+
+/* Move the batch's buffers into an Arrow struct array.
+ * names gives the column names (NULL for "f0", "f1", ...). */
+csvkit_error_t csvkit_batch_export_arrow(csvkit_batch_t *batch, const char *const *names,
+                                         struct ArrowSchema *schema, struct ArrowArray *array);
+
+/* Release the storage of a batch initialized with csvkit_batch_init() */
+void csvkit_batch_release(csvkit_batch_t *batch);
+
 /*
  * Writer API
  */
@@ -134,8 +412,41 @@ csvkit_error_t csvkit_writer_open_stream(csvkit_writer_t *writer, FILE *stream);
 /* Write a row to CSV */
 csvkit_error_t csvkit_writer_write_row(csvkit_writer_t *writer, const char **fields, size_t field_count);
 
-/* Close the writer */
-void csvkit_writer_close(csvkit_writer_t *writer);
+/* Write a row of fields with known lengths, which may contain NUL bytes */
+csvkit_error_t csvkit_writer_write_row_n(csvkit_writer_t *writer, const char **fields,
+                                         const size_t *lengths, size_t field_count);
+
+/* Order of the cells of a table passed to csvkit_writer_write_rows() */
+typedef enum {
+    CSVKIT_ROW_MAJOR = 0,   /* Row by row: cell (r, c) at [r * column_count + c] */
+    CSVKIT_COLUMN_MAJOR     /* Column by column: cell (r, c) at [c * row_count + r] */
+} csvkit_layout_t;
+
+/* Write row_count rows of column_count fields each. lengths may be NULL
+ * for NUL-terminated fields. */
+csvkit_error_t csvkit_writer_write_rows(csvkit_writer_t *writer, const char **fields,
+                                        const size_t *lengths, size_t row_count,
+                                        size_t column_count, csvkit_layout_t layout);
+
+/* Write the rows of a columnar batch, formatting typed values directly.
+ * The columns may point at caller-owned buffers; a NULL validity bitmap
+ * means the column has no nulls. Nulls are written as empty fields. */
+csvkit_error_t csvkit_writer_write_batch(csvkit_writer_t *writer, const csvkit_batch_t *batch);
+
+/* Build a row one field at a time, formatting values straight into the
+ * output, and end it with csvkit_writer_end_row(). Doubles are written as
+ * the shortest decimal that reads back as the same value. */
+csvkit_error_t csvkit_writer_write_field(csvkit_writer_t *writer, const char *data, size_t len);
+csvkit_error_t csvkit_writer_write_int64(csvkit_writer_t *writer, int64_t value);
+csvkit_error_t csvkit_writer_write_double(csvkit_writer_t *writer, double value);
+csvkit_error_t csvkit_writer_write_bool(csvkit_writer_t *writer, bool value);
+csvkit_error_t csvkit_writer_end_row(csvkit_writer_t *writer);
+
+/* Write out the rows held in the writer's buffer and flush the stream */
+csvkit_error_t csvkit_writer_flush(csvkit_writer_t *writer);
+
+/* Close the writer, writing out any output still held */
+csvkit_error_t csvkit_writer_close(csvkit_writer_t *writer);
 
 /* Free the writer */
 void csvkit_writer_free(csvkit_writer_t *writer);
@@ -0,0 +1,477 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+#include "parser_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Arrow C Data Interface, as defined by the Arrow specification */
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+    void (*release)(struct ArrowSchema *);
+    void *private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+    void (*release)(struct ArrowArray *);
+    void *private_data;
+};
+
+#endif /* ARROW_C_DATA_INTERFACE */
+
+#define INITIAL_BATCH_ROWS 64
+#define INITIAL_COLUMN_DATA 4096
+
+void csvkit_batch_init(csvkit_batch_t *batch) {
+    if (!batch) return;
+    memset(batch, 0, sizeof(*batch));
+}
+
+/* Bytes of data for `rows` values of a fixed-width column */
+static size_t fixed_data_size(csvkit_type_t type, size_t rows) {
+    switch (type) {
+        case CSVKIT_TYPE_INT64:
+        case CSVKIT_TYPE_TIMESTAMP:
+            return rows * sizeof(int64_t);
+        case CSVKIT_TYPE_DOUBLE:
+            return rows * sizeof(double);
+        case CSVKIT_TYPE_DATE:
+            return rows * sizeof(int32_t);
+        case CSVKIT_TYPE_BOOL:
+            return (rows + 7) / 8;
+        default:
+            return 0;
+    }
+}
+
+static bool reserve_data(csvkit_column_t *column, size_t needed);
+
+/* Make room for `rows` rows, keeping the rows already stored */
+static bool reserve_rows(csvkit_column_t *column, size_t rows) {
+    if (rows <= column->row_capacity) return true;
+
+    size_t new_capacity = column->row_capacity ? column->row_capacity : INITIAL_BATCH_ROWS;
+    while (new_capacity < rows) {
+        if (new_capacity > SIZE_MAX / 2) return false;
+        new_capacity *= 2;
+    }
+    /* Offsets and the widest values take 8 bytes per row */
+    if (new_capacity > SIZE_MAX / sizeof(int64_t) - 1) return false;
+
+    uint8_t *validity = realloc(column->validity, (new_capacity + 7) / 8);
+    if (!validity) return false;
+    column->validity = validity;
+
+    if (column->type == CSVKIT_TYPE_STRING) {
+        int64_t *offsets = realloc(column->offsets, (new_capacity + 1) * sizeof(int64_t));
+        if (!offsets) return false;
+        column->offsets = offsets;
+    } else if (!reserve_data(column, fixed_data_size(column->type, new_capacity))) {
+        return false;
+    }
+
+    column->row_capacity = new_capacity;
+    return true;
+}
+
+static bool reserve_data(csvkit_column_t *column, size_t needed) {
+    if (needed <= column->data_capacity) return true;
+
+    size_t new_capacity = column->data_capacity ? column->data_capacity : INITIAL_COLUMN_DATA;
+    while (new_capacity < needed) {
+        if (new_capacity > SIZE_MAX / 2) return false;
+        new_capacity *= 2;
+    }
+
+    char *data = realloc(column->data, new_capacity);
+    if (!data) return false;
+
+    column->data = data;
+    column->data_capacity = new_capacity;
+    return true;
+}
+
+static inline void set_bit(uint8_t *bits, size_t index, bool value) {
+    uint8_t bit = (uint8_t)(1u << (index & 7));
+    if (value) {
+        bits[index >> 3] |= bit;
+    } else {
+        bits[index >> 3] &= (uint8_t)~bit;
+    }
+}
+
+/* Append a string field; the data buffer must already have room for it */
+static inline void append_field(csvkit_column_t *column, size_t row, const char *data, size_t len) {
+    int64_t end = column->offsets[row];
+    if (len > 0) {
+        memcpy(column->data + end, data, len);
+    }
+    column->offsets[row + 1] = end + (int64_t)len;
+    set_bit(column->validity, row, true);
+}
+
+/* Store a converted value in a fixed-width column */
+static inline void append_value(csvkit_column_t *column, size_t row, const csvkit_value_t *value) {
+    switch (column->type) {
+        case CSVKIT_TYPE_INT64:
+            memcpy(column->data + row * sizeof(int64_t), &value->value.int64, sizeof(int64_t));
+            break;
+        case CSVKIT_TYPE_TIMESTAMP:
+            memcpy(column->data + row * sizeof(int64_t), &value->value.timestamp, sizeof(int64_t));
+            break;
+        case CSVKIT_TYPE_DOUBLE:
+            memcpy(column->data + row * sizeof(double), &value->value.float64, sizeof(double));
+            break;
+        case CSVKIT_TYPE_DATE:
+            memcpy(column->data + row * sizeof(int32_t), &value->value.date, sizeof(int32_t));
+            break;
+        case CSVKIT_TYPE_BOOL:
+            set_bit((uint8_t *)column->data, row, value->value.boolean);
+            break;
+        default:
+            break;
+    }
+    set_bit(column->validity, row, true);
+}
+
+static inline void append_null(csvkit_column_t *column, size_t row) {
+    if (column->type == CSVKIT_TYPE_STRING) {
+        column->offsets[row + 1] = column->offsets[row];
+    } else {
+        /* Null slots are zeroed so that exported buffers are deterministic */
+        static const csvkit_value_t zero;
+        append_value(column, row, &zero);
+    }
+    set_bit(column->validity, row, false);
+    column->null_count++;
+}
+
+/* Switch a column to `type`, dropping buffers laid out for another type */
+static void set_column_type(csvkit_column_t *column, csvkit_type_t type) {
+    if (column->type == type) return;
+
+    free(column->validity);
+    free(column->offsets);
+    free(column->data);
+    memset(column, 0, sizeof(*column));
+    column->type = type;
+}
+
+/* Widen the batch to `count` columns. Rows already in the batch did not
+ * have the new columns, so they are null there. */
+static bool add_columns(csvkit_parser_t *parser, csvkit_batch_t *batch, size_t count) {
+    if (count > batch->column_capacity) {
+        csvkit_column_t *columns = realloc(batch->columns, count * sizeof(csvkit_column_t));
+        if (!columns) return false;
+        memset(columns + batch->column_capacity, 0,
+               (count - batch->column_capacity) * sizeof(csvkit_column_t));
+        batch->columns = columns;
+        batch->column_capacity = count;
+    }
+
+    while (batch->column_count < count) {
+        csvkit_column_t *column = &batch->columns[batch->column_count];
+        set_column_type(column, csvkit_column_type(parser, batch->column_count));
+        if (!reserve_rows(column, batch->row_count + 1) || !reserve_data(column, 1)) {
+            return false;
+        }
+
+        if (column->type == CSVKIT_TYPE_STRING) {
+            column->offsets[0] = 0;
+        }
+        column->null_count = 0;
+        for (size_t row = 0; row < batch->row_count; row++) {
+            append_null(column, row);
+        }
+        batch->column_count++;
+    }
+
+    return true;
+}
+
+csvkit_error_t csvkit_read_batch(csvkit_parser_t *parser, csvkit_batch_t *batch, size_t max_rows) {
+    if (!parser || !batch || max_rows == 0) return CSVKIT_ERROR_INVALID_ARG;
+
+    /* Columns are discovered again from the rows of each batch */
+    batch->column_count = 0;
+    batch->row_count = 0;
+
+    csvkit_typed_row_t typed;
+    csvkit_error_t result = CSVKIT_OK;
+
+    while (batch->row_count < max_rows) {
+        /* Typed fields are converted before anything is appended, so a
+         * failure leaves no partial row behind */
+        result = csvkit_read_row_typed(parser, &typed);
+        if (result != CSVKIT_OK) break;
+
+        size_t row = batch->row_count;
+        if (typed.field_count > batch->column_count &&
+            !add_columns(parser, batch, typed.field_count)) {
+            result = CSVKIT_ERROR_MEMORY;
+            break;
+        }
+
+        /* Columns grow with the rows read; max_rows is only a limit */
+        for (size_t i = 0; i < batch->column_count; i++) {
+            if (!reserve_rows(&batch->columns[i], row + 1)) {
+                result = CSVKIT_ERROR_MEMORY;
+                break;
+            }
+        }
+        for (size_t i = 0; result == CSVKIT_OK && i < typed.field_count; i++) {
+            csvkit_column_t *column = &batch->columns[i];
+            if (column->type == CSVKIT_TYPE_STRING &&
+                !reserve_data(column, (size_t)column->offsets[row] + typed.fields[i].len)) {
+                result = CSVKIT_ERROR_MEMORY;
+                break;
+            }
+        }
+        if (result != CSVKIT_OK) break;
+
+        for (size_t i = 0; i < batch->column_count; i++) {
+            csvkit_column_t *column = &batch->columns[i];
+            if (i >= typed.field_count || typed.values[i].is_null) {
+                append_null(column, row);
+            } else if (column->type == CSVKIT_TYPE_STRING) {
+                append_field(column, row, typed.fields[i].data, typed.fields[i].len);
+            } else {
+                append_value(column, row, &typed.values[i]);
+            }
+        }
+        batch->row_count++;
+    }
+
+    if (result == CSVKIT_ERROR_EOF && batch->row_count > 0) {
+        return CSVKIT_OK;
+    }
+    return result;
+}
+
+void csvkit_batch_release(csvkit_batch_t *batch) {
+    if (!batch) return;
+
+    for (size_t i = 0; i < batch->column_capacity; i++) {
+        free(batch->columns[i].validity);
+        free(batch->columns[i].offsets);
+        free(batch->columns[i].data);
+    }
+    free(batch->columns);
+    memset(batch, 0, sizeof(*batch));
+}
+
+/*
+ * Arrow export
+ *
+ * The batch is exported as a struct array with one nullable child per
+ * column: large string ("U") for string columns, the matching primitive
+ * type otherwise. Each child owns its buffers, so a consumer may move
+ * children out and release them independently.
+ */
+
+typedef struct {
+    const void *buffers[3];       /* Validity, then offsets and data or values */
+} column_export_t;
+
+static const char *arrow_format(csvkit_type_t type) {
+    switch (type) {
+        case CSVKIT_TYPE_INT64: return "l";
+        case CSVKIT_TYPE_DOUBLE: return "g";
+        case CSVKIT_TYPE_BOOL: return "b";
+        case CSVKIT_TYPE_DATE: return "tdD";
+        case CSVKIT_TYPE_TIMESTAMP: return "tsu:UTC";
+        default: return "U";
+    }
+}
+
+static void release_column_schema(struct ArrowSchema *schema) {
+    free((char *)schema->name);
+    schema->release = NULL;
+}
+
+static void release_batch_schema(struct ArrowSchema *schema) {
+    for (int64_t i = 0; i < schema->n_children; i++) {
+        struct ArrowSchema *child = schema->children[i];
+        if (child->release) {
+            child->release(child);
+        }
+    }
+    free(schema->private_data);
+    free(schema->children);
+    schema->release = NULL;
+}
+
+static void release_column_array(struct ArrowArray *array) {
+    column_export_t *export = array->private_data;
+    for (int i = 0; i < 3; i++) {
+        free((void *)export->buffers[i]);
+    }
+    free(export);
+    array->release = NULL;
+}
+
+static void release_batch_array(struct ArrowArray *array) {
+    for (int64_t i = 0; i < array->n_children; i++) {
+        struct ArrowArray *child = array->children[i];
+        if (child->release) {
+            child->release(child);
+        }
+    }
+    free(array->private_data);
+    free(array->children);
+    free(array->buffers);
+    array->release = NULL;
+}
+
+static char *column_name(const char *const *names, size_t index) {
+    char generated[32];
+    const char *name = names ? names[index] : NULL;
+
+    if (!name) {
+        snprintf(generated, sizeof(generated), "f%zu", index);
+        name = generated;
+    }
+
+    size_t len = strlen(name);
+    char *copy = malloc(len + 1);
+    if (copy) {
+        memcpy(copy, name, len + 1);
+    }
+    return copy;
+}
+
+csvkit_error_t csvkit_batch_export_arrow(csvkit_batch_t *batch, const char *const *names,
+                                         struct ArrowSchema *schema, struct ArrowArray *array) {
+    if (!batch || !schema || !array) return CSVKIT_ERROR_INVALID_ARG;
+
+    size_t count = batch->column_count;
+    size_t slots = count ? count : 1;
+
+    struct ArrowSchema *child_schemas = calloc(slots, sizeof(struct ArrowSchema));
+    struct ArrowSchema **schema_children = calloc(slots, sizeof(struct ArrowSchema *));
+    struct ArrowArray *child_arrays = calloc(slots, sizeof(struct ArrowArray));
+    struct ArrowArray **array_children = calloc(slots, sizeof(struct ArrowArray *));
+    const void **buffers = calloc(1, sizeof(void *));
+    column_export_t **exports = calloc(slots, sizeof(column_export_t *));
+    char **column_names = calloc(slots, sizeof(char *));
+    bool ok = child_schemas && schema_children && child_arrays && array_children &&
+              buffers && exports && column_names;
+
+    for (size_t i = 0; ok && i < count; i++) {
+        exports[i] = malloc(sizeof(column_export_t));
+        column_names[i] = column_name(names, i);
+        ok = exports[i] && column_names[i];
+    }
+
+    if (!ok) {
+        for (size_t i = 0; exports && column_names && i < count; i++) {
+            free(exports[i]);
+            free(column_names[i]);
+        }
+        free(child_schemas);
+        free(schema_children);
+        free(child_arrays);
+        free(array_children);
+        free((void *)buffers);
+        free(exports);
+        free(column_names);
+        return CSVKIT_ERROR_MEMORY;
+    }
+
+    int64_t length = (int64_t)batch->row_count;
+
+    for (size_t i = 0; i < count; i++) {
+        csvkit_column_t *column = &batch->columns[i];
+        column_export_t *export = exports[i];
+
+        /* Arrow allows leaving out the validity bitmap when nothing is null */
+        if (column->null_count == 0) {
+            free(column->validity);
+            export->buffers[0] = NULL;
+        } else {
+            export->buffers[0] = column->validity;
+        }
+        if (column->type == CSVKIT_TYPE_STRING) {
+            export->buffers[1] = column->offsets;
+            export->buffers[2] = column->data;
+        } else {
+            export->buffers[1] = column->data;
+            export->buffers[2] = NULL;
+        }
+
+        /* The buffers belong to the export now */
+        column->validity = NULL;
+        column->offsets = NULL;
+        column->data = NULL;
+        column->row_capacity = 0;
+        column->data_capacity = 0;
+
+        struct ArrowSchema *child_schema = &child_schemas[i];
+        child_schema->format = arrow_format(column->type);
+        child_schema->name = column_names[i];
+        child_schema->flags = ARROW_FLAG_NULLABLE;
+        child_schema->release = release_column_schema;
+        schema_children[i] = child_schema;
+
+        struct ArrowArray *child_array = &child_arrays[i];
+        child_array->length = length;
+        child_array->null_count = (int64_t)column->null_count;
+        child_array->n_buffers = column->type == CSVKIT_TYPE_STRING ? 3 : 2;
+        child_array->buffers = export->buffers;
+        child_array->release = release_column_array;
+        child_array->private_data = export;
+        array_children[i] = child_array;
+    }
+    free(exports);
+    free(column_names);
+
+    memset(schema, 0, sizeof(*schema));
+    schema->format = "+s";
+    schema->name = "";
+    schema->n_children = (int64_t)count;
+    schema->children = schema_children;
+    schema->release = release_batch_schema;
+    schema->private_data = child_schemas;
+
+    memset(array, 0, sizeof(*array));
+    array->length = length;
+    array->n_buffers = 1;
+    array->n_children = (int64_t)count;
+    array->buffers = buffers;
+    array->children = array_children;
+    array->release = release_batch_array;
+    array->private_data = child_arrays;
+
+    batch->column_count = 0;
+    batch->row_count = 0;
+    return CSVKIT_OK;
+}
@@ -0,0 +1,229 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/*
+ * gzip and zstd compression of writer output (config.compression).
+ *
+ * The encoder compresses the formatted CSV into its own output buffer and
+ * writes that buffer to the stream whenever it fills up, so the stream
+ * sees few large writes. With config.compression_threads, zstd compresses
+ * on its own worker threads while the caller keeps formatting rows.
+ */
+
+#include "compress.h"
+#include <limits.h>
+#include <stdlib.h>
+
+#ifdef CSVKIT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CSVKIT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define ENCODER_OUTPUT_SIZE (128 * 1024)
+
+typedef enum {
+    ENCODE_CONTINUE,              /* Compress as much as the format likes */
+    ENCODE_FLUSH,                 /* Make everything so far decodable */
+    ENCODE_END                    /* End the compressed stream */
+} encode_mode_t;
+
+struct csvkit_encoder {
+    csvkit_compression_t format;
+    char *out;                    /* Compressed bytes not yet written */
+    size_t out_len;
+    const char *error;            /* Why compression failed, or NULL */
+#ifdef CSVKIT_HAVE_ZLIB
+    z_stream zs;
+    bool zs_ready;
+#endif
+#ifdef CSVKIT_HAVE_ZSTD
+    ZSTD_CCtx *zcs;
+#endif
+};
+
+csvkit_encoder_t *csvkit_encoder_new(csvkit_compression_t format, int level, unsigned threads,
+                                     const char **error) {
+    (void)level;
+    (void)threads;
+
+    *error = "Out of memory";
+    csvkit_encoder_t *encoder = calloc(1, sizeof(csvkit_encoder_t));
+    if (!encoder) return NULL;
+
+    encoder->format = format;
+    encoder->out = malloc(ENCODER_OUTPUT_SIZE);
+    if (!encoder->out) {
+        free(encoder);
+        return NULL;
+    }
+
+    switch (format) {
+    case CSVKIT_COMPRESSION_GZIP:
+#ifdef CSVKIT_HAVE_ZLIB
+        if (level < 0 || level > 9) {
+            *error = "Invalid compression level";
+            break;
+        }
+        /* 16 + MAX_WBITS: gzip wrapper */
+        if (deflateInit2(&encoder->zs, level == 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED,
+                         16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            break;
+        }
+        encoder->zs_ready = true;
+        return encoder;
+#else
+        *error = "gzip output is not supported by this build";
+        break;
+#endif
+    case CSVKIT_COMPRESSION_ZSTD:
+#ifdef CSVKIT_HAVE_ZSTD
+        encoder->zcs = ZSTD_createCCtx();
+        if (!encoder->zcs) break;
+        if (ZSTD_isError(ZSTD_CCtx_setParameter(encoder->zcs, ZSTD_c_compressionLevel, level))) {
+            *error = "Invalid compression level";
+            break;
+        }
+        /* Fails when libzstd was built without threads, which leaves
+         * compression on the calling thread */
+        if (threads > 0 && threads <= INT_MAX) {
+            ZSTD_CCtx_setParameter(encoder->zcs, ZSTD_c_nbWorkers, (int)threads);
+        }
+        return encoder;
+#else
+        *error = "zstd output is not supported by this build";
+        break;
+#endif
+    default:
+        *error = "Invalid compression format";
+        break;
+    }
+
+    csvkit_encoder_free(encoder);
+    return NULL;
+}
+
+void csvkit_encoder_free(csvkit_encoder_t *encoder) {
+    if (!encoder) return;
+
+#ifdef CSVKIT_HAVE_ZLIB
+    if (encoder->zs_ready) {
+        deflateEnd(&encoder->zs);
+    }
+#endif
+#ifdef CSVKIT_HAVE_ZSTD
+    ZSTD_freeCCtx(encoder->zcs);
+#endif
+    free(encoder->out);
+    free(encoder);
+}
+
+const char *csvkit_encoder_error(const csvkit_encoder_t *encoder) {
+    return encoder ? encoder->error : NULL;
+}
+
+/* Write out the compressed bytes held in the output buffer */
+static bool drain(csvkit_encoder_t *encoder, FILE *out) {
+    if (encoder->out_len > 0 && fwrite(encoder->out, 1, encoder->out_len, out) != encoder->out_len) {
+        encoder->error = "Write error";
+        return false;
+    }
+    encoder->out_len = 0;
+    return true;
+}
+
+#ifdef CSVKIT_HAVE_ZLIB
+static bool deflate_data(csvkit_encoder_t *encoder, const char *data, size_t len,
+                         encode_mode_t mode, FILE *out) {
+    z_stream *zs = &encoder->zs;
+    zs->next_in = (Bytef *)(uintptr_t)data;
+
+    for (;;) {
+        uInt step = len > UINT_MAX ? UINT_MAX : (uInt)len;
+        zs->avail_in = step;
+        zs->next_out = (Bytef *)encoder->out + encoder->out_len;
+        zs->avail_out = (uInt)(ENCODER_OUTPUT_SIZE - encoder->out_len);
+
+        int flush = Z_NO_FLUSH;
+        if (step == len && mode != ENCODE_CONTINUE) {
+            flush = mode == ENCODE_END ? Z_FINISH : Z_SYNC_FLUSH;
+        }
+        int status = deflate(zs, flush);
+        if (status == Z_STREAM_ERROR) {
+            encoder->error = "gzip compression failed";
+            return false;
+        }
+        len -= step - zs->avail_in;
+        encoder->out_len = ENCODER_OUTPUT_SIZE - zs->avail_out;
+
+        /* Output space left over means deflate() has taken all it can */
+        bool full = zs->avail_out == 0;
+        if (full && !drain(encoder, out)) return false;
+        if (flush == Z_FINISH ? status == Z_STREAM_END : len == 0 && !full) return true;
+    }
+}
+#endif
+
+#ifdef CSVKIT_HAVE_ZSTD
+static bool zstd_data(csvkit_encoder_t *encoder, const char *data, size_t len,
+                      encode_mode_t mode, FILE *out) {
+    ZSTD_inBuffer input = {data, len, 0};
+
+    for (;;) {
+        ZSTD_outBuffer output = {encoder->out, ENCODER_OUTPUT_SIZE, encoder->out_len};
+        ZSTD_EndDirective directive = mode == ENCODE_END ? ZSTD_e_end :
+                                      mode == ENCODE_FLUSH ? ZSTD_e_flush : ZSTD_e_continue;
+        size_t remaining = ZSTD_compressStream2(encoder->zcs, &output, &input, directive);
+        encoder->out_len = output.pos;
+        if (ZSTD_isError(remaining)) {
+            encoder->error = "zstd compression failed";
+            return false;
+        }
+
+        if (encoder->out_len == ENCODER_OUTPUT_SIZE && !drain(encoder, out)) return false;
+        /* Flushing and ending return 0 once everything is out */
+        if (mode != ENCODE_CONTINUE ? remaining == 0 : input.pos == input.size) return true;
+    }
+}
+#endif
+
+static bool compress_data(csvkit_encoder_t *encoder, const char *data, size_t len,
+                          encode_mode_t mode, FILE *out) {
+    if (encoder->error) return false;
+
+#ifdef CSVKIT_HAVE_ZLIB
+    if (encoder->format == CSVKIT_COMPRESSION_GZIP) {
+        return deflate_data(encoder, data, len, mode, out);
+    }
+#endif
+#ifdef CSVKIT_HAVE_ZSTD
+    if (encoder->format == CSVKIT_COMPRESSION_ZSTD) {
+        return zstd_data(encoder, data, len, mode, out);
+    }
+#endif
+    (void)data;
+    (void)len;
+    (void)mode;
+    (void)out;
+    return false;
+}
+
+bool csvkit_encoder_write(csvkit_encoder_t *encoder, const char *data, size_t len, FILE *out) {
+    return len == 0 || compress_data(encoder, data, len, ENCODE_CONTINUE, out);
+}
+
+bool csvkit_encoder_flush(csvkit_encoder_t *encoder, FILE *out) {
+    return compress_data(encoder, "", 0, ENCODE_FLUSH, out) && drain(encoder, out);
+}
+
+bool csvkit_encoder_finish(csvkit_encoder_t *encoder, FILE *out) {
+    return compress_data(encoder, "", 0, ENCODE_END, out) && drain(encoder, out);
+}
@@ -0,0 +1,40 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/* Internal compressor for writer output - not part of the public API */
+
+#ifndef CSVKIT_COMPRESS_H
+#define CSVKIT_COMPRESS_H
+
+#include "csvkit.h"
+
+typedef struct csvkit_encoder csvkit_encoder_t;
+
+/* Set up a compressor. Returns NULL with *error set when the format is
+ * not supported by this build, the level is out of range, or memory
+ * runs out. level 0 is the format's default; threads only apply to zstd. */
+csvkit_encoder_t *csvkit_encoder_new(csvkit_compression_t format, int level, unsigned threads,
+                                     const char **error);
+void csvkit_encoder_free(csvkit_encoder_t *encoder);
+
+/* Compress len bytes, writing compressed output to out as it fills up.
+ * Returns false on failure; csvkit_encoder_error() then says why. */
+bool csvkit_encoder_write(csvkit_encoder_t *encoder, const char *data, size_t len, FILE *out);
+
+/* Write everything compressed so far to out, in a form a decoder can
+ * read without the rest of the stream. Costs some compression. */
+bool csvkit_encoder_flush(csvkit_encoder_t *encoder, FILE *out);
+
+/* End the compressed stream and write everything still held to out */
+bool csvkit_encoder_finish(csvkit_encoder_t *encoder, FILE *out);
+
+const char *csvkit_encoder_error(const csvkit_encoder_t *encoder);
+
+#endif /* CSVKIT_COMPRESS_H */
@@ -0,0 +1,718 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/* Typed field conversion. The kernels accept exactly one value spanning
+ * the whole field: no surrounding whitespace, no locale-dependent
+ * characters. */
+
+#define _GNU_SOURCE  /* strtod_l() */
+
+#include "parser_internal.h"
+#include "powers.h"
+#include <float.h>
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline bool is_digit(char c) {
+    return (unsigned char)(c - '0') < 10;
+}
+
+static inline char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+/* Case-insensitive comparison against a lowercase literal */
+static bool equals_lower(const char *data, size_t len, const char *word) {
+    size_t word_len = strlen(word);
+    if (len != word_len) return false;
+
+    for (size_t i = 0; i < len; i++) {
+        if (to_lower(data[i]) != word[i]) return false;
+    }
+    return true;
+}
+
+/* Eight digits per step on little-endian targets, as in scan.c */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define CSVKIT_SWAR_DIGITS 1
+
+static inline uint64_t load_eight(const char *p) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+static inline bool is_eight_digits(uint64_t word) {
+    return (((word & UINT64_C(0xF0F0F0F0F0F0F0F0)) |
+             (((word + UINT64_C(0x0606060606060606)) & UINT64_C(0xF0F0F0F0F0F0F0F0)) >> 4)) ==
+            UINT64_C(0x3333333333333333));
+}
+
+static inline uint64_t parse_eight_digits(uint64_t word) {
+    const uint64_t mask = UINT64_C(0x000000FF000000FF);
+    const uint64_t mul1 = UINT64_C(0x000F424000000064);  /* 100 + (1000000 << 32) */
+    const uint64_t mul2 = UINT64_C(0x0000271000000001);  /* 1 + (10000 << 32) */
+
+    word -= UINT64_C(0x3030303030303030);
+    word = (word * 10) + (word >> 8);
+    return (((word & mask) * mul1) + (((word >> 16) & mask) * mul2)) >> 32;
+}
+#endif
+
+/* Accumulate the digits of p[0..end) into *value, stopping at the first
+ * non-digit. Overflows silently past 19 digits; callers count digits. */
+static inline const char *parse_digits(const char *p, const char *end, uint64_t *value) {
+    uint64_t n = *value;
+
+#ifdef CSVKIT_SWAR_DIGITS
+    while (end - p >= 8 && is_eight_digits(load_eight(p))) {
+        n = n * 100000000 + parse_eight_digits(load_eight(p));
+        p += 8;
+    }
+#endif
+    while (p < end && is_digit(*p)) {
+        n = n * 10 + (uint64_t)(*p - '0');
+        p++;
+    }
+
+    *value = n;
+    return p;
+}
+
+/*
+ * Integers
+ */
+
+csvkit_error_t csvkit_parse_int64(const char *data, size_t len, int64_t *value) {
+    if (!data || !value) return CSVKIT_ERROR_INVALID_ARG;
+
+    const char *p = data;
+    const char *end = data + len;
+    bool negative = false;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end) return CSVKIT_ERROR_PARSE;
+
+    /* Leading zeros do not count towards the 19 digits that fit */
+    while (end - p > 1 && *p == '0') {
+        p++;
+    }
+    const char *digits = p;
+
+    uint64_t n = 0;
+    p = parse_digits(p, end, &n);
+    if (p != end || p - digits > 19) return CSVKIT_ERROR_PARSE;
+
+    uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    if (n > limit) return CSVKIT_ERROR_PARSE;
+
+    *value = negative ? (int64_t)(0 - n) : (int64_t)n;
+    return CSVKIT_OK;
+}
+
+/*
+ * Floating point
+ *
+ * The decimal is reduced to w * 10^q with a 64-bit w. Small values take
+ * Clinger's exact path; the rest go through the Eisel-Lemire algorithm,
+ * which only gives up on inputs too close to a rounding boundary. Those,
+ * and decimals with more than 19 significant digits whose truncation
+ * changes the result, are left to strtod_l() in the C locale.
+ */
+
+#define DOUBLE_MANTISSA_BITS 52
+#define DOUBLE_MIN_EXPONENT (-1023)
+#define DOUBLE_INFINITE_POWER 0x7FF
+#define MIN_NINETEEN_DIGITS UINT64_C(1000000000000000000)
+
+typedef struct {
+    uint64_t high;
+    uint64_t low;
+} uint128_parts_t;
+
+static inline uint128_parts_t full_multiply(uint64_t a, uint64_t b) {
+    uint128_parts_t r;
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 product = (uint128)a * b;
+    r.high = (uint64_t)(product >> 64);
+    r.low = (uint64_t)product;
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi;
+    uint64_t hi_hi = a_hi * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+    r.high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+    r.low = (cross << 32) | (uint32_t)lo_lo;
+#endif
+    return r;
+}
+
+static inline int leading_zeros(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    while (!(x & (UINT64_C(1) << 63))) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Binary exponent of 10^q, minus 63: floor(q * log2(10)) */
+static inline int32_t binary_power(int32_t q) {
+    return (((152170 + 65536) * q) >> 16) + 63;
+}
+
+/* Eisel-Lemire: set *bits to the IEEE encoding (without sign) of w * 10^q.
+ * Returns false when the result cannot be decided from 128 bits. */
+static bool eisel_lemire(uint64_t w, int64_t q, uint64_t *bits) {
+    if (w == 0 || q < POWER_OF_FIVE_MIN) {
+        *bits = 0;
+        return true;
+    }
+    if (q > POWER_OF_FIVE_MAX) {
+        *bits = (uint64_t)DOUBLE_INFINITE_POWER << DOUBLE_MANTISSA_BITS;
+        return true;
+    }
+
+    int lz = leading_zeros(w);
+    w <<= lz;
+
+    size_t index = 2 * (size_t)(q - POWER_OF_FIVE_MIN);
+    uint128_parts_t product = full_multiply(w, power_of_five_128[index]);
+    const uint64_t precision_mask = UINT64_MAX >> (DOUBLE_MANTISSA_BITS + 3);
+    if ((product.high & precision_mask) == precision_mask) {
+        uint128_parts_t second = full_multiply(w, power_of_five_128[index + 1]);
+        product.low += second.high;
+        if (second.high > product.low) {
+            product.high++;
+        }
+    }
+    if (product.low == UINT64_MAX && (q < -27 || q > 55)) {
+        return false;
+    }
+
+    int upperbit = (int)(product.high >> 63);
+    int shift = upperbit + 64 - DOUBLE_MANTISSA_BITS - 3;
+    uint64_t mantissa = product.high >> shift;
+    int32_t power2 = binary_power((int32_t)q) + upperbit - lz - DOUBLE_MIN_EXPONENT;
+
+    if (power2 <= 0) {
+        /* Subnormal */
+        if (-power2 + 1 >= 64) {
+            *bits = 0;
+            return true;
+        }
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power2 = mantissa < (UINT64_C(1) << DOUBLE_MANTISSA_BITS) ? 0 : 1;
+        *bits = (mantissa & ((UINT64_C(1) << DOUBLE_MANTISSA_BITS) - 1)) |
+                ((uint64_t)power2 << DOUBLE_MANTISSA_BITS);
+        return true;
+    }
+
+    /* Exactly halfway between two doubles: round to even */
+    if (product.low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+        (mantissa << shift) == product.high) {
+        mantissa &= ~UINT64_C(1);
+    }
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (UINT64_C(2) << DOUBLE_MANTISSA_BITS)) {
+        mantissa = UINT64_C(1) << DOUBLE_MANTISSA_BITS;
+        power2++;
+    }
+    mantissa &= ~(UINT64_C(1) << DOUBLE_MANTISSA_BITS);
+
+    if (power2 >= DOUBLE_INFINITE_POWER) {
+        power2 = DOUBLE_INFINITE_POWER;
+        mantissa = 0;
+    }
+    *bits = mantissa | ((uint64_t)power2 << DOUBLE_MANTISSA_BITS);
+    return true;
+}
+
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static pthread_once_t c_locale_once = PTHREAD_ONCE_INIT;
+static locale_t c_locale;
+
+static void create_c_locale(void) {
+    c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+}
+
+/* Slow path for inputs that were already validated by csvkit_parse_double() */
+static bool parse_double_fallback(const char *data, size_t len, double *value) {
+    pthread_once(&c_locale_once, create_c_locale);
+    if (c_locale == (locale_t)0) return false;
+
+    char small[128];
+    char *copy = len < sizeof(small) ? small : malloc(len + 1);
+    if (!copy) return false;
+    memcpy(copy, data, len);
+    copy[len] = '\0';
+
+    char *parsed_end;
+    *value = strtod_l(copy, &parsed_end, c_locale);
+    bool ok = parsed_end == copy + len;
+
+    if (copy != small) {
+        free(copy);
+    }
+    return ok;
+}
+
+static bool parse_special_double(const char *p, size_t len, bool negative, double *value) {
+    if (equals_lower(p, len, "inf") || equals_lower(p, len, "infinity")) {
+        *value = negative ? -HUGE_VAL : HUGE_VAL;
+        return true;
+    }
+    if (equals_lower(p, len, "nan")) {
+        *value = negative ? -(double)NAN : (double)NAN;
+        return true;
+    }
+    return false;
+}
+
+csvkit_error_t csvkit_parse_double(const char *data, size_t len, double *value) {
+    if (!data || !value) return CSVKIT_ERROR_INVALID_ARG;
+
+    const char *p = data;
+    const char *end = data + len;
+    bool negative = false;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    /* Decimal digits with an optional fraction */
+    uint64_t w = 0;
+    const char *int_start = p;
+    p = parse_digits(p, end, &w);
+    const char *int_end = p;
+    int64_t exponent = 0;
+    const char *frac_start = p;
+    const char *frac_end = p;
+
+    if (p < end && *p == '.') {
+        p++;
+        frac_start = p;
+        p = parse_digits(p, end, &w);
+        frac_end = p;
+        exponent = -(int64_t)(frac_end - frac_start);
+    }
+
+    int64_t digit_count = (int_end - int_start) + (frac_end - frac_start);
+    if (digit_count == 0) {
+        if (parse_special_double(int_start, (size_t)(end - int_start), negative, value)) {
+            return CSVKIT_OK;
+        }
+        return CSVKIT_ERROR_PARSE;
+    }
+
+    /* Optional exponent; huge exponents saturate */
+    int64_t exp_number = 0;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool exp_negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            exp_negative = *p == '-';
+            p++;
+        }
+        if (p == end || !is_digit(*p)) return CSVKIT_ERROR_PARSE;
+        while (p < end && is_digit(*p)) {
+            if (exp_number < 0x10000000) {
+                exp_number = exp_number * 10 + (*p - '0');
+            }
+            p++;
+        }
+        if (exp_negative) {
+            exp_number = -exp_number;
+        }
+    }
+    if (p != end) return CSVKIT_ERROR_PARSE;
+    exponent += exp_number;
+
+    /* More than 19 digits: keep the first 19 significant ones */
+    bool truncated = false;
+    if (digit_count > 19) {
+        const char *start = int_start;
+        while (start < frac_end && (*start == '0' || *start == '.')) {
+            if (*start == '0') digit_count--;
+            start++;
+        }
+        if (digit_count > 19) {
+            truncated = true;
+            w = 0;
+            const char *q = int_start;
+            while (w < MIN_NINETEEN_DIGITS && q < int_end) {
+                w = w * 10 + (uint64_t)(*q - '0');
+                q++;
+            }
+            if (w >= MIN_NINETEEN_DIGITS) {
+                exponent = (int_end - q) + exp_number;
+            } else {
+                q = frac_start;
+                while (w < MIN_NINETEEN_DIGITS && q < frac_end) {
+                    w = w * 10 + (uint64_t)(*q - '0');
+                    q++;
+                }
+                exponent = (frac_start - q) + exp_number;
+            }
+        }
+    }
+
+#if FLT_EVAL_METHOD == 0
+    /* Clinger: both w and 10^|q| are exact doubles, so one rounding */
+    if (!truncated && exponent >= -22 && exponent <= 22 &&
+        w <= (UINT64_C(1) << (DOUBLE_MANTISSA_BITS + 1))) {
+        double d = (double)w;
+        if (exponent < 0) {
+            d /= exact_powers_of_ten[-exponent];
+        } else {
+            d *= exact_powers_of_ten[exponent];
+        }
+        *value = negative ? -d : d;
+        return CSVKIT_OK;
+    }
+#endif
+
+    uint64_t bits;
+    bool decided = eisel_lemire(w, exponent, &bits);
+    if (decided && truncated) {
+        /* The dropped digits lie between w and w + 1 */
+        uint64_t upper;
+        decided = eisel_lemire(w + 1, exponent, &upper) && upper == bits;
+    }
+
+    if (!decided) {
+        return parse_double_fallback(data, len, value) ? CSVKIT_OK : CSVKIT_ERROR_MEMORY;
+    }
+
+    if (negative) {
+        bits |= UINT64_C(1) << 63;
+    }
+    memcpy(value, &bits, sizeof(*value));
+    return CSVKIT_OK;
+}
+
+/*
+ * Booleans: true/false in any case, or 1/0
+ */
+
+csvkit_error_t csvkit_parse_bool(const char *data, size_t len, bool *value) {
+    if (!data || !value) return CSVKIT_ERROR_INVALID_ARG;
+
+    if (len == 1 && (data[0] == '1' || data[0] == '0')) {
+        *value = data[0] == '1';
+        return CSVKIT_OK;
+    }
+    if (equals_lower(data, len, "true")) {
+        *value = true;
+        return CSVKIT_OK;
+    }
+    if (equals_lower(data, len, "false")) {
+        *value = false;
+        return CSVKIT_OK;
+    }
+    return CSVKIT_ERROR_PARSE;
+}
+
+/*
+ * Dates and timestamps (ISO 8601)
+ */
+
+/* Read exactly `count` digits */
+static bool fixed_digits(const char **p, const char *end, int count, int *value) {
+    if (end - *p < count) return false;
+
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        char c = (*p)[i];
+        if (!is_digit(c)) return false;
+        n = n * 10 + (c - '0');
+    }
+    *p += count;
+    *value = n;
+    return true;
+}
+
+static bool is_leap_year(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+/* Days since 1970-01-01 of a proleptic Gregorian date */
+static int64_t days_from_civil(int year, int month, int day) {
+    int64_t y = year - (month <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/* YYYY-MM-DD */
+static bool parse_date_part(const char **p, const char *end, int64_t *days) {
+    static const int month_days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    int year, month, day;
+
+    if (!fixed_digits(p, end, 4, &year) || *p == end || **p != '-') return false;
+    (*p)++;
+    if (!fixed_digits(p, end, 2, &month) || *p == end || **p != '-') return false;
+    (*p)++;
+    if (!fixed_digits(p, end, 2, &day)) return false;
+
+    if (month < 1 || month > 12 || day < 1) return false;
+    int max_day = month_days[month - 1] + (month == 2 && is_leap_year(year));
+    if (day > max_day) return false;
+
+    *days = days_from_civil(year, month, day);
+    return true;
+}
+
+csvkit_error_t csvkit_parse_date(const char *data, size_t len, int32_t *days) {
+    if (!data || !days) return CSVKIT_ERROR_INVALID_ARG;
+
+    const char *p = data;
+    const char *end = data + len;
+    int64_t value;
+
+    if (!parse_date_part(&p, end, &value) || p != end) return CSVKIT_ERROR_PARSE;
+
+    *days = (int32_t)value;
+    return CSVKIT_OK;
+}
+
+/* Z, +HH, +HHMM or +HH:MM; sets the offset east of UTC in seconds */
+static bool parse_utc_offset(const char **p, const char *end, int64_t *seconds) {
+    if (**p == 'Z' || **p == 'z') {
+        (*p)++;
+        *seconds = 0;
+        return true;
+    }
+    if (**p != '+' && **p != '-') return false;
+
+    int sign = **p == '-' ? -1 : 1;
+    int hours, minutes = 0;
+    (*p)++;
+    if (!fixed_digits(p, end, 2, &hours)) return false;
+    if (*p < end) {
+        if (**p == ':') {
+            (*p)++;
+        }
+        if (!fixed_digits(p, end, 2, &minutes)) return false;
+    }
+    if (hours > 23 || minutes > 59) return false;
+
+    *seconds = sign * (hours * 3600 + minutes * 60);
+    return true;
+}
+
+csvkit_error_t csvkit_parse_timestamp(const char *data, size_t len, int64_t *micros) {
+    if (!data || !micros) return CSVKIT_ERROR_INVALID_ARG;
+
+    const char *p = data;
+    const char *end = data + len;
+    int64_t days;
+    int64_t seconds = 0;
+    int64_t fraction = 0;
+
+    if (!parse_date_part(&p, end, &days)) return CSVKIT_ERROR_PARSE;
+
+    /* Optional time of day: [T ]HH:MM[:SS[.fraction]] */
+    if (p < end && (*p == 'T' || *p == 't' || *p == ' ')) {
+        int hour, minute, second = 0;
+        p++;
+        if (!fixed_digits(&p, end, 2, &hour) || p == end || *p != ':') return CSVKIT_ERROR_PARSE;
+        p++;
+        if (!fixed_digits(&p, end, 2, &minute)) return CSVKIT_ERROR_PARSE;
+        if (p < end && *p == ':') {
+            p++;
+            if (!fixed_digits(&p, end, 2, &second)) return CSVKIT_ERROR_PARSE;
+            if (p < end && (*p == '.' || *p == ',')) {
+                /* Digits past microseconds are truncated */
+                int digits = 0;
+                p++;
+                if (p == end || !is_digit(*p)) return CSVKIT_ERROR_PARSE;
+                while (p < end && is_digit(*p)) {
+                    if (digits < 6) {
+                        fraction = fraction * 10 + (*p - '0');
+                        digits++;
+                    }
+                    p++;
+                }
+                while (digits < 6) {
+                    fraction *= 10;
+                    digits++;
+                }
+            }
+        }
+        if (hour > 23 || minute > 59 || second > 59) return CSVKIT_ERROR_PARSE;
+        seconds = hour * 3600 + minute * 60 + second;
+
+        if (p < end) {
+            int64_t offset;
+            if (!parse_utc_offset(&p, end, &offset)) return CSVKIT_ERROR_PARSE;
+            seconds -= offset;
+        }
+    }
+    if (p != end) return CSVKIT_ERROR_PARSE;
+
+    *micros = (days * 86400 + seconds) * 1000000 + fraction;
+    return CSVKIT_OK;
+}
+
+/*
+ * Row accessors
+ */
+
+static const char *row_field(const csvkit_row_t *row, size_t index) {
+    return row && index < row->field_count ? row->fields[index] : NULL;
+}
+
+csvkit_error_t csvkit_row_get_int64(const csvkit_row_t *row, size_t index, int64_t *value) {
+    const char *field = row_field(row, index);
+    if (!field) return CSVKIT_ERROR_INVALID_ARG;
+    return csvkit_parse_int64(field, strlen(field), value);
+}
+
+csvkit_error_t csvkit_row_get_double(const csvkit_row_t *row, size_t index, double *value) {
+    const char *field = row_field(row, index);
+    if (!field) return CSVKIT_ERROR_INVALID_ARG;
+    return csvkit_parse_double(field, strlen(field), value);
+}
+
+csvkit_error_t csvkit_row_get_bool(const csvkit_row_t *row, size_t index, bool *value) {
+    const char *field = row_field(row, index);
+    if (!field) return CSVKIT_ERROR_INVALID_ARG;
+    return csvkit_parse_bool(field, strlen(field), value);
+}
+
+csvkit_error_t csvkit_row_get_date(const csvkit_row_t *row, size_t index, int32_t *value) {
+    const char *field = row_field(row, index);
+    if (!field) return CSVKIT_ERROR_INVALID_ARG;
+    return csvkit_parse_date(field, strlen(field), value);
+}
+
+csvkit_error_t csvkit_row_get_timestamp(const csvkit_row_t *row, size_t index, int64_t *value) {
+    const char *field = row_field(row, index);
+    if (!field) return CSVKIT_ERROR_INVALID_ARG;
+    return csvkit_parse_timestamp(field, strlen(field), value);
+}
+
+/*
+ * Schema mode
+ */
+
+static const char *type_name(csvkit_type_t type) {
+    switch (type) {
+        case CSVKIT_TYPE_INT64: return "int64";
+        case CSVKIT_TYPE_DOUBLE: return "double";
+        case CSVKIT_TYPE_BOOL: return "bool";
+        case CSVKIT_TYPE_DATE: return "date";
+        case CSVKIT_TYPE_TIMESTAMP: return "timestamp";
+        default: return "string";
+    }
+}
+
+csvkit_error_t csvkit_convert_field(csvkit_type_t type, const char *data, size_t len,
+                                    csvkit_value_t *value) {
+    value->is_null = len == 0 && type != CSVKIT_TYPE_STRING;
+    if (value->is_null) return CSVKIT_OK;
+
+    switch (type) {
+        case CSVKIT_TYPE_INT64:
+            return csvkit_parse_int64(data, len, &value->value.int64);
+        case CSVKIT_TYPE_DOUBLE:
+            return csvkit_parse_double(data, len, &value->value.float64);
+        case CSVKIT_TYPE_BOOL:
+            return csvkit_parse_bool(data, len, &value->value.boolean);
+        case CSVKIT_TYPE_DATE:
+            return csvkit_parse_date(data, len, &value->value.date);
+        case CSVKIT_TYPE_TIMESTAMP:
+            return csvkit_parse_timestamp(data, len, &value->value.timestamp);
+        default:
+            return CSVKIT_OK;
+    }
+}
+
+void csvkit_report_conversion_error(csvkit_parser_t *parser, csvkit_error_t result, size_t column) {
+    char msg[96];
+
+    if (result == CSVKIT_ERROR_MEMORY) {
+        snprintf(msg, sizeof(msg), "Out of memory");
+    } else {
+        snprintf(msg, sizeof(msg), "Invalid %s value in row %zu, column %zu",
+                 type_name(csvkit_column_type(parser, column)), parser->row_number, column);
+    }
+    csvkit_set_error(parser, msg);
+}
+
+csvkit_error_t csvkit_read_row_typed(csvkit_parser_t *parser, csvkit_typed_row_t *row) {
+    if (!parser || !row) return CSVKIT_ERROR_INVALID_ARG;
+
+    row->values = NULL;
+    row->fields = NULL;
+    row->field_count = 0;
+
+    csvkit_row_view_t view;
+    csvkit_error_t result = csvkit_read_row_view(parser, &view);
+    if (result != CSVKIT_OK) return result;
+
+    if (view.field_count > parser->value_capacity) {
+        size_t new_capacity = parser->value_capacity ? parser->value_capacity : INITIAL_FIELD_COUNT;
+        while (new_capacity < view.field_count) {
+            new_capacity *= 2;
+        }
+        csvkit_value_t *values = realloc(parser->values, new_capacity * sizeof(csvkit_value_t));
+        if (!values) {
+            csvkit_report_conversion_error(parser, CSVKIT_ERROR_MEMORY, 0);
+            return CSVKIT_ERROR_MEMORY;
+        }
+        parser->values = values;
+        parser->value_capacity = new_capacity;
+    }
+
+    /* Convert while the row's bytes are still in cache */
+    for (size_t i = 0; i < view.field_count; i++) {
+        result = csvkit_convert_field(csvkit_column_type(parser, i), view.fields[i].data,
+                                      view.fields[i].len, &parser->values[i]);
+        if (result != CSVKIT_OK) {
+            csvkit_report_conversion_error(parser, result, i);
+            return result;
+        }
+    }
+
+    row->values = parser->values;
+    row->fields = view.fields;
+    row->field_count = view.field_count;
+    row->row_number = view.row_number;
+    return CSVKIT_OK;
+}
@@ -0,0 +1,242 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Decompression of gzip and zstd file and stream sources
+ * (config.decompress).
+ *
+ * A decoder sits between the source and the input window: it pulls
+ * compressed bytes through a read function into its own buffer and
+ * produces decompressed bytes on demand. Concatenated gzip members and
+ * zstd frames are decoded as one stream, as gzip -d and zstd -d do.
+ * Formats are recognised by their magic bytes even when the library was
+ * built without them, so such input fails with a clear error instead of
+ * being parsed as CSV.
+ */
+
+#include "parser_internal.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CSVKIT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CSVKIT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define DECODER_INPUT_SIZE (128 * 1024)
+
+struct csvkit_decoder {
+    csvkit_compression_t format;
+    char *in;                     /* Compressed bytes, consumed from in_pos */
+    size_t in_pos;
+    size_t in_len;
+    bool raw_eof;                 /* The source has no more compressed bytes */
+    bool in_stream;               /* Inside a gzip member or zstd frame */
+    const char *error;            /* Why decoding failed, or NULL */
+#ifdef CSVKIT_HAVE_ZLIB
+    z_stream zs;
+    bool zs_ready;
+#endif
+#ifdef CSVKIT_HAVE_ZSTD
+    ZSTD_DStream *zds;
+#endif
+};
+
+csvkit_compression_t csvkit_detect_compression(const unsigned char *bytes, size_t len) {
+    if (len >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) return CSVKIT_COMPRESSION_GZIP;
+    if (len >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 && bytes[2] == 0x2f && bytes[3] == 0xfd) {
+        return CSVKIT_COMPRESSION_ZSTD;
+    }
+    return CSVKIT_COMPRESSION_NONE;
+}
+
+bool csvkit_magic_prefix(const unsigned char *bytes, size_t len) {
+    static const unsigned char gzip[] = {0x1f, 0x8b};
+    static const unsigned char zstd[] = {0x28, 0xb5, 0x2f, 0xfd};
+    return (len < sizeof(gzip) && memcmp(bytes, gzip, len) == 0) ||
+           (len < sizeof(zstd) && memcmp(bytes, zstd, len) == 0);
+}
+
+csvkit_decoder_t *csvkit_decoder_new(csvkit_compression_t format, const char *initial,
+                                     size_t initial_len) {
+    csvkit_decoder_t *decoder = calloc(1, sizeof(csvkit_decoder_t));
+    if (!decoder) return NULL;
+
+    decoder->format = format;
+    decoder->in = malloc(DECODER_INPUT_SIZE > initial_len ? DECODER_INPUT_SIZE : initial_len);
+    if (!decoder->in) {
+        free(decoder);
+        return NULL;
+    }
+    if (initial_len > 0) {
+        memcpy(decoder->in, initial, initial_len);
+    }
+    decoder->in_len = initial_len;
+    decoder->in_stream = true;
+
+    switch (format) {
+    case CSVKIT_COMPRESSION_GZIP:
+#ifdef CSVKIT_HAVE_ZLIB
+        /* 16 + MAX_WBITS: gzip wrapper only */
+        if (inflateInit2(&decoder->zs, 16 + MAX_WBITS) != Z_OK) {
+            csvkit_decoder_free(decoder);
+            return NULL;
+        }
+        decoder->zs_ready = true;
+#else
+        decoder->error = "gzip input is not supported by this build";
+#endif
+        break;
+    case CSVKIT_COMPRESSION_ZSTD:
+#ifdef CSVKIT_HAVE_ZSTD
+        decoder->zds = ZSTD_createDStream();
+        if (!decoder->zds || ZSTD_isError(ZSTD_initDStream(decoder->zds))) {
+            csvkit_decoder_free(decoder);
+            return NULL;
+        }
+#else
+        decoder->error = "zstd input is not supported by this build";
+#endif
+        break;
+    default:
+        break;
+    }
+    return decoder;
+}
+
+void csvkit_decoder_reset(csvkit_decoder_t *decoder) {
+    decoder->in_pos = 0;
+    decoder->in_len = 0;
+    decoder->raw_eof = false;
+    decoder->in_stream = true;
+#ifdef CSVKIT_HAVE_ZLIB
+    if (decoder->zs_ready) {
+        inflateReset(&decoder->zs);
+        decoder->error = NULL;
+    }
+#endif
+#ifdef CSVKIT_HAVE_ZSTD
+    if (decoder->zds) {
+        ZSTD_initDStream(decoder->zds);
+        decoder->error = NULL;
+    }
+#endif
+}
+
+void csvkit_decoder_free(csvkit_decoder_t *decoder) {
+    if (!decoder) return;
+
+#ifdef CSVKIT_HAVE_ZLIB
+    if (decoder->zs_ready) {
+        inflateEnd(&decoder->zs);
+    }
+#endif
+#ifdef CSVKIT_HAVE_ZSTD
+    ZSTD_freeDStream(decoder->zds);
+#endif
+    free(decoder->in);
+    free(decoder);
+}
+
+const char *csvkit_decoder_error(const csvkit_decoder_t *decoder) {
+    return decoder ? decoder->error : NULL;
+}
+
+/* Decompress from the buffered input into dest. Returns the bytes
+ * produced, which may be 0 while headers are consumed. */
+static size_t decode(csvkit_decoder_t *decoder, char *dest, size_t len) {
+    const char *in = decoder->in + decoder->in_pos;
+    size_t in_len = decoder->in_len - decoder->in_pos;
+
+#ifdef CSVKIT_HAVE_ZLIB
+    if (decoder->format == CSVKIT_COMPRESSION_GZIP) {
+        z_stream *zs = &decoder->zs;
+        if (!decoder->in_stream) {
+            /* Another member follows the last one */
+            inflateReset(zs);
+            decoder->in_stream = true;
+        }
+        zs->next_in = (Bytef *)(uintptr_t)in;
+        zs->avail_in = in_len > UINT_MAX ? UINT_MAX : (uInt)in_len;
+        zs->next_out = (Bytef *)dest;
+        zs->avail_out = len > UINT_MAX ? UINT_MAX : (uInt)len;
+        uInt out_space = zs->avail_out;
+
+        int status = inflate(zs, Z_NO_FLUSH);
+        decoder->in_pos = (size_t)((const char *)zs->next_in - decoder->in);
+        if (status == Z_STREAM_END) {
+            decoder->in_stream = false;
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            decoder->error = "Corrupt gzip input";
+        }
+        return out_space - zs->avail_out;
+    }
+#endif
+#ifdef CSVKIT_HAVE_ZSTD
+    if (decoder->format == CSVKIT_COMPRESSION_ZSTD) {
+        ZSTD_inBuffer input = {in, in_len, 0};
+        ZSTD_outBuffer output = {dest, len, 0};
+        size_t status = ZSTD_decompressStream(decoder->zds, &output, &input);
+        decoder->in_pos += input.pos;
+        if (ZSTD_isError(status)) {
+            decoder->error = "Corrupt zstd input";
+        } else {
+            /* 0 once a frame is complete and flushed */
+            decoder->in_stream = status != 0;
+        }
+        return output.pos;
+    }
+#endif
+    (void)in;
+    (void)in_len;
+    (void)dest;
+    (void)len;
+    return 0;
+}
+
+size_t csvkit_decoder_read(csvkit_decoder_t *decoder, char *dest, size_t len,
+                           csvkit_source_read_t read_source, void *context, int *error) {
+    for (;;) {
+        if (decoder->error) {
+            *error = EIO;
+            return 0;
+        }
+
+        if (decoder->in_pos == decoder->in_len && !decoder->raw_eof) {
+            int read_error = 0;
+            size_t got = read_source(context, decoder->in, DECODER_INPUT_SIZE, &read_error);
+            if (read_error != 0) {
+                *error = read_error;
+                return 0;
+            }
+            decoder->in_pos = 0;
+            decoder->in_len = got;
+            decoder->raw_eof = got == 0;
+        }
+
+        bool ended = decoder->in_pos == decoder->in_len;
+        if (ended && !decoder->in_stream) return 0;
+
+        /* At the end of the source this only flushes what the decoder holds */
+        size_t produced = decode(decoder, dest, len);
+        if (produced > 0) return produced;
+
+        /* The source has ended: cleanly only between members or frames */
+        if (ended) {
+            if (!decoder->in_stream) return 0;
+            decoder->error = decoder->format == CSVKIT_COMPRESSION_GZIP ?
+                             "Truncated gzip input" : "Truncated zstd input";
+        }
+    }
+}
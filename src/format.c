@@ -0,0 +1,426 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/* Value formatting for the writer. Nothing here depends on the locale
+ * or allocates, and every value is written with one pass over its
+ * digits. */
+
+#include "format.h"
+#include "format_tables.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static inline int digit_count(uint64_t v) {
+    int n = 1;
+    for (;;) {
+        if (v < 10) return n;
+        if (v < 100) return n + 1;
+        if (v < 1000) return n + 2;
+        if (v < 10000) return n + 3;
+        v /= 10000;
+        n += 4;
+    }
+}
+
+/* Write the `count` low digits of v, zero-padded, ending at end */
+static inline void put_digits(char *end, uint64_t v, int count) {
+    while (count >= 2) {
+        end -= 2;
+        memcpy(end, digit_pairs + 2 * (v % 100), 2);
+        v /= 100;
+        count -= 2;
+    }
+    if (count > 0) {
+        *--end = (char)('0' + v % 10);
+    }
+}
+
+static inline char *format_uint64(char *out, uint64_t v) {
+    int n = digit_count(v);
+    put_digits(out + n, v, n);
+    return out + n;
+}
+
+char *csvkit_format_int64(char *out, int64_t value) {
+    uint64_t v = (uint64_t)value;
+    if (value < 0) {
+        *out++ = '-';
+        v = 0 - v;
+    }
+    return format_uint64(out, v);
+}
+
+/*
+ * Doubles: Ryu (Ulf Adams, "Ryu: fast float-to-string conversion", PLDI
+ * 2018) finds the shortest digits in the rounding interval of the value
+ * with 128-bit fixed-point multiplications.
+ */
+
+#define DOUBLE_MANTISSA_BITS 52
+#define DOUBLE_EXPONENT_BITS 11
+#define DOUBLE_BIAS 1023
+
+/* floor(e * log10(2)) for e in [0, 1650] */
+static inline uint32_t log10_pow2(int32_t e) {
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+/* floor(e * log10(5)) for e in [0, 2620] */
+static inline uint32_t log10_pow5(int32_t e) {
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+/* Bit length of 5^e for e in [0, 3528] */
+static inline int32_t pow5_bits(int32_t e) {
+    return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+static inline bool multiple_of_pow5(uint64_t v, uint32_t p) {
+    uint32_t count = 0;
+    while (v % 5 == 0) {
+        v /= 5;
+        count++;
+    }
+    return count >= p;
+}
+
+static inline bool multiple_of_pow2(uint64_t v, uint32_t p) {
+    return (v & ((UINT64_C(1) << p) - 1)) == 0;
+}
+
+/* (m * mul) >> j for a 128-bit mul (low word first) and j in [65, 127] */
+static inline uint64_t mul_shift(uint64_t m, const uint64_t *mul, int32_t j) {
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 low = (uint128)m * mul[0];
+    uint128 high = (uint128)m * mul[1];
+    return (uint64_t)(((low >> 64) + high) >> (j - 64));
+#else
+    uint64_t m_lo = (uint32_t)m, m_hi = m >> 32;
+    uint64_t sum_lo, sum_hi;
+    uint64_t parts[2][2];
+    for (int i = 0; i < 2; i++) {
+        uint64_t b_lo = (uint32_t)mul[i], b_hi = mul[i] >> 32;
+        uint64_t lo_lo = m_lo * b_lo;
+        uint64_t hi_lo = m_hi * b_lo;
+        uint64_t lo_hi = m_lo * b_hi;
+        uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+        parts[i][1] = m_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+        parts[i][0] = (cross << 32) | (uint32_t)lo_lo;
+    }
+    sum_lo = parts[1][0] + parts[0][1];
+    sum_hi = parts[1][1] + (sum_lo < parts[1][0]);
+    int32_t shift = j - 64;
+    return (sum_hi << (64 - shift)) | (sum_lo >> shift);
+#endif
+}
+
+/* Shortest decimal digits * 10^exponent of a finite, nonzero double */
+static uint64_t shortest_digits(uint64_t ieee_mantissa, uint32_t ieee_exponent, int32_t *exponent) {
+    int32_t e2;
+    uint64_t m2;
+    if (ieee_exponent == 0) {
+        e2 = 1 - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = (int32_t)ieee_exponent - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = (UINT64_C(1) << DOUBLE_MANTISSA_BITS) | ieee_mantissa;
+    }
+    bool accept_bounds = (m2 & 1) == 0;
+
+    /* The value and the halfway points to its neighbours, times 4. The
+     * lower neighbour is closer when the value is a power of two. */
+    uint64_t mv = 4 * m2;
+    uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+    /* Scale the three by a power of ten into 64-bit decimals */
+    uint64_t vr, vp, vm;
+    int32_t e10;
+    bool vm_trailing_zeros = false;
+    bool vr_trailing_zeros = false;
+    if (e2 >= 0) {
+        uint32_t q = log10_pow2(e2) - (e2 > 3);
+        e10 = (int32_t)q;
+        int32_t k = POW5_INV_BITCOUNT + pow5_bits((int32_t)q) - 1;
+        int32_t i = -e2 + (int32_t)q + k;
+        vr = mul_shift(4 * m2, pow5_inv_split[q], i);
+        vp = mul_shift(4 * m2 + 2, pow5_inv_split[q], i);
+        vm = mul_shift(4 * m2 - 1 - mm_shift, pow5_inv_split[q], i);
+        if (q <= 21) {
+            /* Exact when the scale divides: only then can dropped digits
+             * all be zeros */
+            if (mv % 5 == 0) {
+                vr_trailing_zeros = multiple_of_pow5(mv, q);
+            } else if (accept_bounds) {
+                vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+            } else {
+                vp -= multiple_of_pow5(mv + 2, q);
+            }
+        }
+    } else {
+        uint32_t q = log10_pow5(-e2) - (-e2 > 1);
+        e10 = (int32_t)q + e2;
+        int32_t i = -e2 - (int32_t)q;
+        int32_t k = pow5_bits(i) - POW5_BITCOUNT;
+        int32_t j = (int32_t)q - k;
+        vr = mul_shift(4 * m2, pow5_split[i], j);
+        vp = mul_shift(4 * m2 + 2, pow5_split[i], j);
+        vm = mul_shift(4 * m2 - 1 - mm_shift, pow5_split[i], j);
+        if (q <= 1) {
+            vr_trailing_zeros = true;
+            if (accept_bounds) {
+                vm_trailing_zeros = mm_shift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 63) {
+            vr_trailing_zeros = multiple_of_pow2(mv, q);
+        }
+    }
+
+    /* Drop digits while the interval (vm, vp) still holds a decimal */
+    int32_t removed = 0;
+    uint8_t last_removed = 0;
+    uint64_t output;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = (uint8_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = (uint8_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        /* Exactly halfway: round to even */
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+            last_removed = 4;
+        }
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+    } else {
+        /* The common case: nothing is exact, so just round */
+        bool round_up = false;
+        if (vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+
+    *exponent = e10 + removed;
+    return output;
+}
+
+/* Integers below 2^53 need no search: their digits are the value */
+static bool small_integer(uint64_t ieee_mantissa, uint32_t ieee_exponent, uint64_t *value) {
+    int32_t e2 = (int32_t)ieee_exponent - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS;
+    if (e2 > 0 || e2 < -DOUBLE_MANTISSA_BITS) return false;
+
+    uint64_t m2 = (UINT64_C(1) << DOUBLE_MANTISSA_BITS) | ieee_mantissa;
+    uint64_t mask = (UINT64_C(1) << -e2) - 1;
+    if (m2 & mask) return false;
+
+    *value = m2 >> -e2;
+    return true;
+}
+
+char *csvkit_format_double(char *out, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bool negative = (bits >> 63) != 0;
+    uint64_t ieee_mantissa = bits & ((UINT64_C(1) << DOUBLE_MANTISSA_BITS) - 1);
+    uint32_t ieee_exponent = (uint32_t)(bits >> DOUBLE_MANTISSA_BITS) &
+                             ((1u << DOUBLE_EXPONENT_BITS) - 1);
+
+    if (ieee_exponent == (1u << DOUBLE_EXPONENT_BITS) - 1) {
+        if (ieee_mantissa != 0) {
+            memcpy(out, "nan", 3);
+            return out + 3;
+        }
+        if (negative) *out++ = '-';
+        memcpy(out, "inf", 3);
+        return out + 3;
+    }
+    if (negative) *out++ = '-';
+    if (ieee_exponent == 0 && ieee_mantissa == 0) {
+        *out = '0';
+        return out + 1;
+    }
+
+    uint64_t digits;
+    int32_t exponent = 0;
+    if (small_integer(ieee_mantissa, ieee_exponent, &digits)) {
+        while (digits % 10 == 0) {
+            digits /= 10;
+            exponent++;
+        }
+    } else {
+        digits = shortest_digits(ieee_mantissa, ieee_exponent, &exponent);
+    }
+
+    /* value = digits * 10^exponent = d.ddd * 10^point */
+    int n = digit_count(digits);
+    int32_t point = exponent + n - 1;
+
+    if (point >= -4 && point < 17) {
+        if (exponent >= 0) {
+            put_digits(out + n, digits, n);
+            memset(out + n, '0', (size_t)exponent);
+            return out + n + exponent;
+        }
+        if (point >= 0) {
+            /* Digits on both sides of the point */
+            int whole = point + 1;
+            put_digits(out + n + 1, digits, n);
+            memmove(out, out + 1, (size_t)whole);
+            out[whole] = '.';
+            return out + n + 1;
+        }
+        int zeros = -point - 1;
+        out[0] = '0';
+        out[1] = '.';
+        memset(out + 2, '0', (size_t)zeros);
+        put_digits(out + 2 + zeros + n, digits, n);
+        return out + 2 + zeros + n;
+    }
+
+    /* d[.ddd]e+XX */
+    put_digits(out + n + 1, digits, n);
+    out[0] = out[1];
+    if (n > 1) {
+        out[1] = '.';
+        out += n + 1;
+    } else {
+        out += 1;
+    }
+    *out++ = 'e';
+    if (point < 0) {
+        *out++ = '-';
+        point = -point;
+    } else {
+        *out++ = '+';
+    }
+    if (point >= 100) {
+        *out++ = (char)('0' + point / 100);
+        point %= 100;
+    }
+    memcpy(out, digit_pairs + 2 * point, 2);
+    return out + 2;
+}
+
+/*
+ * Dates and timestamps (ISO 8601)
+ */
+
+/* Proleptic Gregorian date of a day count since 1970-01-01 */
+static void civil_from_days(int64_t days, int64_t *year, unsigned *month, unsigned *day) {
+    int64_t z = days + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    *day = (unsigned)(doy - (153 * mp + 2) / 5 + 1);
+    *month = (unsigned)(mp < 10 ? mp + 3 : mp - 9);
+    *year = yoe + era * 400 + (*month <= 2);
+}
+
+static char *format_date_part(char *out, int64_t days) {
+    int64_t year;
+    unsigned month, day;
+    civil_from_days(days, &year, &month, &day);
+
+    /* At least four year digits; years outside 0000-9999 cannot be read back */
+    uint64_t y = (uint64_t)year;
+    if (year < 0) {
+        *out++ = '-';
+        y = 0 - y;
+    }
+    int n = digit_count(y);
+    if (n < 4) n = 4;
+    put_digits(out + n, y, n);
+    out += n;
+
+    out[0] = '-';
+    memcpy(out + 1, digit_pairs + 2 * month, 2);
+    out[3] = '-';
+    memcpy(out + 4, digit_pairs + 2 * day, 2);
+    return out + 6;
+}
+
+char *csvkit_format_date(char *out, int32_t days) {
+    return format_date_part(out, days);
+}
+
+char *csvkit_format_timestamp(char *out, int64_t micros) {
+    static const int64_t micros_per_day = INT64_C(86400000000);
+    int64_t days = micros / micros_per_day;
+    int64_t rest = micros % micros_per_day;
+    if (rest < 0) {
+        rest += micros_per_day;
+        days--;
+    }
+
+    out = format_date_part(out, days);
+
+    uint64_t seconds = (uint64_t)rest / 1000000;
+    uint64_t fraction = (uint64_t)rest % 1000000;
+    out[0] = 'T';
+    memcpy(out + 1, digit_pairs + 2 * (seconds / 3600), 2);
+    out[3] = ':';
+    memcpy(out + 4, digit_pairs + 2 * (seconds / 60 % 60), 2);
+    out[6] = ':';
+    memcpy(out + 7, digit_pairs + 2 * (seconds % 60), 2);
+    out += 9;
+
+    if (fraction != 0) {
+        *out++ = '.';
+        if (fraction % 1000 == 0) {
+            put_digits(out + 3, fraction / 1000, 3);
+            out += 3;
+        } else {
+            put_digits(out + 6, fraction, 6);
+            out += 6;
+        }
+    }
+    return out;
+}
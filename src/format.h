@@ -0,0 +1,40 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/* Internal value formatting for the writer - not part of the public API */
+
+#ifndef CSVKIT_FORMAT_H
+#define CSVKIT_FORMAT_H
+
+#include <stdint.h>
+
+/* Most bytes any of the formatters below writes */
+#define FORMAT_VALUE_MAX 32
+
+/* Each formatter writes the text of a value at out, without a NUL, and
+ * returns the end of what it wrote. The text is in the form the typed
+ * parsers in convert.c read back to the same value. */
+
+/* Decimal digits with a leading '-' if negative */
+char *csvkit_format_int64(char *out, int64_t value);
+
+/* The shortest decimal that reads back as the same double, in fixed
+ * notation for magnitudes in [1e-4, 1e17) and as d.ddde+XX otherwise,
+ * like printf's %g. Infinities and NaN are "inf", "-inf" and "nan". */
+char *csvkit_format_double(char *out, double value);
+
+/* YYYY-MM-DD from days since 1970-01-01 */
+char *csvkit_format_date(char *out, int32_t days);
+
+/* YYYY-MM-DDTHH:MM:SS in UTC from microseconds since the epoch, with a
+ * .mmm or .uuuuuu fraction when the time has one */
+char *csvkit_format_timestamp(char *out, int64_t micros);
+
+#endif /* CSVKIT_FORMAT_H */
@@ -0,0 +1,134 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/* Header rows: column names in an open-addressing hash table, so that
+ * fields can be looked up by name without scanning the header */
+
+#include "parser_internal.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_SLOTS 8
+
+struct csvkit_header {
+    csvkit_field_view_t *names;   /* Into data, each followed by a NUL */
+    uint64_t *hashes;             /* Hash of each name */
+    size_t count;
+    char *data;
+    size_t *slots;                /* Column index + 1, or 0 for an empty slot */
+    size_t slot_mask;             /* Slot count - 1 (a power of two) */
+};
+
+/* FNV-1a: header names are short, so a bytewise hash is fast enough */
+static uint64_t hash_name(const char *name, size_t len) {
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+csvkit_header_t *csvkit_header_from_views(const csvkit_field_view_t *names, size_t count) {
+    csvkit_header_t *header = calloc(1, sizeof(csvkit_header_t));
+    if (!header) return NULL;
+
+    /* At most half the slots are used, which keeps probe sequences short */
+    size_t slot_count = MIN_SLOTS;
+    while (slot_count < count * 2) {
+        slot_count *= 2;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += names[i].len + 1;
+    }
+
+    header->names = malloc((count ? count : 1) * sizeof(csvkit_field_view_t));
+    header->hashes = malloc((count ? count : 1) * sizeof(uint64_t));
+    header->data = malloc(total ? total : 1);
+    header->slots = calloc(slot_count, sizeof(size_t));
+    if (!header->names || !header->hashes || !header->data || !header->slots) {
+        csvkit_header_free(header);
+        return NULL;
+    }
+    header->count = count;
+    header->slot_mask = slot_count - 1;
+
+    char *dest = header->data;
+    for (size_t i = 0; i < count; i++) {
+        if (names[i].len > 0) {
+            memcpy(dest, names[i].data, names[i].len);
+        }
+        dest[names[i].len] = '\0';
+        header->names[i].data = dest;
+        header->names[i].len = names[i].len;
+        header->hashes[i] = hash_name(dest, names[i].len);
+        dest += names[i].len + 1;
+
+        /* Duplicate names resolve to their first column */
+        if (csvkit_header_find(header, header->names[i].data, header->names[i].len) != CSVKIT_NO_COLUMN) {
+            continue;
+        }
+        size_t slot = (size_t)header->hashes[i] & header->slot_mask;
+        while (header->slots[slot] != 0) {
+            slot = (slot + 1) & header->slot_mask;
+        }
+        header->slots[slot] = i + 1;
+    }
+
+    return header;
+}
+
+csvkit_header_t *csvkit_header_copy(const csvkit_header_t *header) {
+    if (!header) return NULL;
+    return csvkit_header_from_views(header->names, header->count);
+}
+
+void csvkit_header_free(csvkit_header_t *header) {
+    if (!header) return;
+
+    free(header->names);
+    free(header->hashes);
+    free(header->data);
+    free(header->slots);
+    free(header);
+}
+
+size_t csvkit_header_count(const csvkit_header_t *header) {
+    return header ? header->count : 0;
+}
+
+const char *csvkit_header_name(const csvkit_header_t *header, size_t index) {
+    if (!header || index >= header->count) return NULL;
+    return header->names[index].data;
+}
+
+size_t csvkit_header_find(const csvkit_header_t *header, const char *name, size_t len) {
+    if (!header || (!name && len > 0)) return CSVKIT_NO_COLUMN;
+
+    uint64_t hash = hash_name(name, len);
+    for (size_t slot = (size_t)hash & header->slot_mask; header->slots[slot] != 0;
+         slot = (slot + 1) & header->slot_mask) {
+        size_t column = header->slots[slot] - 1;
+        if (header->hashes[column] == hash && header->names[column].len == len &&
+            (len == 0 || memcmp(header->names[column].data, name, len) == 0)) {
+            return column;
+        }
+    }
+    return CSVKIT_NO_COLUMN;
+}
+
+const char *csvkit_row_get_field_by_name(const csvkit_row_t *row, const csvkit_header_t *header,
+                                         const char *name) {
+    if (!name) return NULL;
+    return csvkit_row_get_field(row, csvkit_header_find(header, name, strlen(name)));
+}
@@ -0,0 +1,391 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/* Schema inference: sample rows through the parser and narrow down the
+ * types every field of a column can be converted to */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "parser_internal.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define DEFAULT_SAMPLE_ROWS 1000
+#define DEFAULT_CHUNK_ROWS 100
+
+#define TYPE_BIT(type) (1u << (type))
+#define ALL_CANDIDATES (TYPE_BIT(CSVKIT_TYPE_INT64) | TYPE_BIT(CSVKIT_TYPE_DOUBLE) | \
+                        TYPE_BIT(CSVKIT_TYPE_BOOL) | TYPE_BIT(CSVKIT_TYPE_DATE) |   \
+                        TYPE_BIT(CSVKIT_TYPE_TIMESTAMP))
+
+/* Types tried in order of preference: 0/1 columns are integers, and
+ * integers are also valid doubles */
+static const csvkit_type_t preferred_types[] = {
+    CSVKIT_TYPE_INT64, CSVKIT_TYPE_DOUBLE, CSVKIT_TYPE_BOOL,
+    CSVKIT_TYPE_DATE, CSVKIT_TYPE_TIMESTAMP
+};
+#define PREFERRED_TYPE_COUNT (sizeof(preferred_types) / sizeof(preferred_types[0]))
+
+typedef struct {
+    unsigned candidates;          /* TYPE_BIT()s still possible */
+    bool nullable;
+    bool has_value;               /* A non-empty field was seen */
+} column_stats_t;
+
+/*
+ * Character classes. A field is only handed to a conversion kernel when
+ * its classes allow that type, so text columns are ruled out after one
+ * pass over their bytes.
+ */
+
+#define CLASS_DIGIT 0x01
+#define CLASS_SIGN  0x02  /* + - */
+#define CLASS_DOT   0x04
+#define CLASS_EXP   0x08  /* e E */
+#define CLASS_OTHER 0x10
+
+#define NUMERIC_CLASSES (CLASS_DIGIT | CLASS_SIGN | CLASS_DOT | CLASS_EXP)
+
+static const unsigned char char_classes[256] = {
+    ['0'] = CLASS_DIGIT, ['1'] = CLASS_DIGIT, ['2'] = CLASS_DIGIT, ['3'] = CLASS_DIGIT,
+    ['4'] = CLASS_DIGIT, ['5'] = CLASS_DIGIT, ['6'] = CLASS_DIGIT, ['7'] = CLASS_DIGIT,
+    ['8'] = CLASS_DIGIT, ['9'] = CLASS_DIGIT,
+    ['+'] = CLASS_SIGN, ['-'] = CLASS_SIGN,
+    ['.'] = CLASS_DOT,
+    ['e'] = CLASS_EXP, ['E'] = CLASS_EXP
+};
+
+static inline bool eight_digits(const char *p) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    return (((word & UINT64_C(0xF0F0F0F0F0F0F0F0)) |
+             (((word + UINT64_C(0x0606060606060606)) & UINT64_C(0xF0F0F0F0F0F0F0F0)) >> 4)) ==
+            UINT64_C(0x3333333333333333));
+}
+
+/* Union of the classes of the bytes of a field. Runs of digits are
+ * checked eight bytes at a time (the test is byte-order independent). */
+static unsigned classify(const char *data, size_t len) {
+    unsigned classes = 0;
+    size_t i = 0;
+
+    while (i < len) {
+        if (len - i >= 8 && eight_digits(data + i)) {
+            classes |= CLASS_DIGIT;
+            i += 8;
+            continue;
+        }
+        unsigned char_class = char_classes[(unsigned char)data[i]];
+        classes |= char_class ? char_class : CLASS_OTHER;
+        i++;
+    }
+    return classes;
+}
+
+static void observe_field(column_stats_t *stats, const char *data, size_t len) {
+    if (len == 0) {
+        stats->nullable = true;
+        return;
+    }
+    stats->has_value = true;
+
+    unsigned candidates = stats->candidates;
+    if (candidates == 0) return;  /* Already a string column */
+
+    unsigned classes = classify(data, len);
+    int64_t i64;
+    int32_t i32;
+    double f64;
+    bool b;
+
+    if ((candidates & TYPE_BIT(CSVKIT_TYPE_INT64)) &&
+        ((classes & ~(CLASS_DIGIT | CLASS_SIGN)) ||
+         csvkit_parse_int64(data, len, &i64) != CSVKIT_OK)) {
+        candidates &= ~TYPE_BIT(CSVKIT_TYPE_INT64);
+    }
+    /* Letters only for inf, infinity and nan */
+    if ((candidates & TYPE_BIT(CSVKIT_TYPE_DOUBLE)) &&
+        (((classes & ~NUMERIC_CLASSES) && len > 9) ||
+         csvkit_parse_double(data, len, &f64) != CSVKIT_OK)) {
+        candidates &= ~TYPE_BIT(CSVKIT_TYPE_DOUBLE);
+    }
+    if ((candidates & TYPE_BIT(CSVKIT_TYPE_BOOL)) &&
+        (len > 5 || csvkit_parse_bool(data, len, &b) != CSVKIT_OK)) {
+        candidates &= ~TYPE_BIT(CSVKIT_TYPE_BOOL);
+    }
+    if (candidates & (TYPE_BIT(CSVKIT_TYPE_DATE) | TYPE_BIT(CSVKIT_TYPE_TIMESTAMP))) {
+        if (len < 10 || data[4] != '-' || data[7] != '-') {
+            candidates &= ~(TYPE_BIT(CSVKIT_TYPE_DATE) | TYPE_BIT(CSVKIT_TYPE_TIMESTAMP));
+        } else {
+            if ((candidates & TYPE_BIT(CSVKIT_TYPE_DATE)) &&
+                (len != 10 || csvkit_parse_date(data, len, &i32) != CSVKIT_OK)) {
+                candidates &= ~TYPE_BIT(CSVKIT_TYPE_DATE);
+            }
+            if ((candidates & TYPE_BIT(CSVKIT_TYPE_TIMESTAMP)) &&
+                csvkit_parse_timestamp(data, len, &i64) != CSVKIT_OK) {
+                candidates &= ~TYPE_BIT(CSVKIT_TYPE_TIMESTAMP);
+            }
+        }
+    }
+
+    stats->candidates = candidates;
+}
+
+typedef struct {
+    column_stats_t *columns;
+    size_t column_count;
+    size_t capacity;
+    size_t rows;
+} sample_t;
+
+static bool observe_row(sample_t *sample, const csvkit_row_view_t *view) {
+    if (view->field_count > sample->capacity) {
+        size_t new_capacity = sample->capacity ? sample->capacity : INITIAL_FIELD_COUNT;
+        while (new_capacity < view->field_count) {
+            new_capacity *= 2;
+        }
+        column_stats_t *columns = realloc(sample->columns, new_capacity * sizeof(column_stats_t));
+        if (!columns) return false;
+        sample->columns = columns;
+        sample->capacity = new_capacity;
+    }
+
+    /* Columns first seen now were missing from the earlier rows */
+    while (sample->column_count < view->field_count) {
+        column_stats_t *stats = &sample->columns[sample->column_count++];
+        stats->candidates = ALL_CANDIDATES;
+        stats->nullable = sample->rows > 0;
+        stats->has_value = false;
+    }
+
+    for (size_t i = 0; i < view->field_count; i++) {
+        observe_field(&sample->columns[i], view->fields[i].data, view->fields[i].len);
+    }
+    for (size_t i = view->field_count; i < sample->column_count; i++) {
+        sample->columns[i].nullable = true;
+    }
+
+    sample->rows++;
+    return true;
+}
+
+/* A blank line: one empty field, projected or not */
+static bool is_blank_row(const csvkit_parser_t *parser, const csvkit_row_view_t *view) {
+    return parser->field_total == 1 && !parser->skipped_data &&
+           (view->field_count == 0 || view->fields[0].len == 0);
+}
+
+/* Input bytes for chunk sampling: the string or mapping of a string
+ * source, or a temporary mapping of a file source */
+static const char *map_source(csvkit_parser_t *parser, size_t *len, void **mapping) {
+    *mapping = NULL;
+
+    if (parser->source_type == SOURCE_STRING) {
+        *len = parser->string_len;
+        return parser->string_data;
+    }
+    if (parser->decoder) return NULL;  /* Offsets are not decompressed offsets */
+
+    struct stat st;
+    if (fstat(parser->fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (unsigned long long)st.st_size > (size_t)-1) {
+        return NULL;
+    }
+
+    void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, parser->fd, 0);
+    if (addr == MAP_FAILED) return NULL;
+
+    *mapping = addr;
+    *len = (size_t)st.st_size;
+    return addr;
+}
+
+/* Sample up to chunk_rows rows starting at the first line after `offset`.
+ * A chunk that starts inside a quoted field usually yields a parse error
+ * or, when every row of the head sample had field_total fields, rows with
+ * another field count; such chunks are dropped. */
+static csvkit_error_t sample_chunk(csvkit_parser_t *chunk_parser, const char *data, size_t len,
+                                   size_t offset, size_t chunk_rows, size_t field_total,
+                                   sample_t *sample) {
+    const char *line = memchr(data + offset, '\n', len - offset);
+    if (!line || (size_t)(line + 1 - data) >= len) return CSVKIT_OK;
+
+    size_t start = (size_t)(line + 1 - data);
+    csvkit_open_string(chunk_parser, data + start, len - start);
+
+    /* Work on a copy so a dropped chunk leaves no trace */
+    sample_t chunk = *sample;
+    chunk.columns = malloc(sample->capacity * sizeof(column_stats_t));
+    if (!chunk.columns) return CSVKIT_ERROR_MEMORY;
+    memcpy(chunk.columns, sample->columns, sample->column_count * sizeof(column_stats_t));
+
+    csvkit_row_view_t view;
+    csvkit_error_t result = CSVKIT_OK;
+    bool consistent = true;
+
+    for (size_t i = 0; i < chunk_rows && consistent; i++) {
+        result = csvkit_read_row_view(chunk_parser, &view);
+        if (result == CSVKIT_ERROR_EOF) break;
+        if (result != CSVKIT_OK ||
+            (field_total > 0 && chunk_parser->field_total != field_total &&
+             !is_blank_row(chunk_parser, &view))) {
+            consistent = false;
+        } else if (!observe_row(&chunk, &view)) {
+            free(chunk.columns);
+            return CSVKIT_ERROR_MEMORY;
+        }
+    }
+    csvkit_close(chunk_parser);
+
+    if (consistent) {
+        free(sample->columns);
+        *sample = chunk;
+    } else {
+        free(chunk.columns);
+    }
+    return CSVKIT_OK;
+}
+
+static csvkit_error_t sample_chunks(csvkit_parser_t *parser, const csvkit_infer_options_t *options,
+                                    uint64_t head_end, size_t field_total, sample_t *sample) {
+    void *mapping;
+    size_t len;
+    const char *data = map_source(parser, &len, &mapping);
+    if (!data || len == 0) return CSVKIT_OK;  /* Nothing to sample */
+
+    /* Chunks parse with the same rules and the resolved projection */
+    csvkit_config_t chunk_config = parser->config;
+    chunk_config.threads = 0;
+    chunk_config.has_header = false;
+    chunk_config.strict_mode = false;
+    chunk_config.columns = parser->projecting ? parser->projection : NULL;
+    chunk_config.column_count = parser->projecting ? parser->projected_count : 0;
+    chunk_config.column_names = NULL;
+    chunk_config.column_name_count = 0;
+    chunk_config.schema = NULL;
+    chunk_config.schema_count = 0;
+
+    csvkit_parser_t *chunk_parser = csvkit_parser_new_with_config(&chunk_config);
+    csvkit_error_t result = chunk_parser ? CSVKIT_OK : CSVKIT_ERROR_MEMORY;
+    size_t chunk_rows = options->chunk_rows ? options->chunk_rows : DEFAULT_CHUNK_ROWS;
+
+    /* Evenly spaced over the part of the input the head sample missed */
+    for (size_t i = 1; result == CSVKIT_OK && i <= options->sample_chunks; i++) {
+        size_t offset = (size_t)(head_end + (len - head_end) / (options->sample_chunks + 1) * i);
+        if (offset >= len) break;
+        result = sample_chunk(chunk_parser, data, len, offset, chunk_rows, field_total, sample);
+    }
+
+    csvkit_parser_free(chunk_parser);
+    if (mapping) {
+        munmap(mapping, len);
+    }
+    return result;
+}
+
+csvkit_error_t csvkit_infer_schema(csvkit_parser_t *parser, const csvkit_infer_options_t *options,
+                                   csvkit_schema_t *schema) {
+    if (!parser || !schema) return CSVKIT_ERROR_INVALID_ARG;
+
+    static const csvkit_infer_options_t default_options = {0, 0, 0};
+    if (!options) {
+        options = &default_options;
+    }
+
+    memset(schema, 0, sizeof(*schema));
+
+    if (!csvkit_rewind(parser)) {
+        csvkit_set_error(parser, "Schema inference requires a file or string source");
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+    /* Sampling stays on this thread; rewinding re-enables threads */
+    parser->parallel_tried = true;
+
+    sample_t sample = {NULL, 0, 0, 0};
+    size_t sample_rows = options->sample_rows ? options->sample_rows : DEFAULT_SAMPLE_ROWS;
+    size_t field_total = 0;
+    csvkit_row_view_t view;
+    csvkit_error_t result = CSVKIT_OK;
+
+    while (sample.rows < sample_rows) {
+        result = csvkit_read_row_view(parser, &view);
+        if (result != CSVKIT_OK) break;
+
+        /* Field count of the head sample's rows, or 0 if it varies */
+        if (sample.rows == 0) {
+            field_total = parser->field_total;
+        } else if (parser->field_total != field_total && !is_blank_row(parser, &view)) {
+            field_total = 0;
+        }
+        if (!observe_row(&sample, &view)) {
+            csvkit_set_error(parser, "Out of memory");
+            result = CSVKIT_ERROR_MEMORY;
+            break;
+        }
+    }
+    if (result == CSVKIT_ERROR_EOF) {
+        result = CSVKIT_OK;
+    } else if (result == CSVKIT_OK && options->sample_chunks > 0) {
+        uint64_t head_end = parser->input_offset + parser->input_pos;
+        result = sample_chunks(parser, options, head_end, field_total, &sample);
+        if (result != CSVKIT_OK) {
+            csvkit_set_error(parser, "Out of memory");
+        }
+    }
+
+    if (result == CSVKIT_OK && sample.column_count > 0) {
+        schema->types = malloc(sample.column_count * sizeof(csvkit_type_t));
+        schema->nullable = malloc(sample.column_count * sizeof(bool));
+        if (!schema->types || !schema->nullable) {
+            csvkit_schema_release(schema);
+            csvkit_set_error(parser, "Out of memory");
+            result = CSVKIT_ERROR_MEMORY;
+        }
+    }
+
+    if (result == CSVKIT_OK) {
+        for (size_t i = 0; i < sample.column_count; i++) {
+            const column_stats_t *stats = &sample.columns[i];
+            csvkit_type_t type = CSVKIT_TYPE_STRING;
+
+            /* Columns without a single value stay strings */
+            for (size_t t = 0; stats->has_value && t < PREFERRED_TYPE_COUNT; t++) {
+                if (stats->candidates & TYPE_BIT(preferred_types[t])) {
+                    type = preferred_types[t];
+                    break;
+                }
+            }
+            schema->types[i] = type;
+            schema->nullable[i] = stats->nullable;
+        }
+        schema->column_count = sample.column_count;
+        schema->rows_sampled = sample.rows;
+    }
+    free(sample.columns);
+
+    /* Leave the parser at the first row again */
+    if (!csvkit_rewind(parser) && result == CSVKIT_OK) {
+        csvkit_schema_release(schema);
+        csvkit_set_error(parser, strerror(errno));
+        result = CSVKIT_ERROR_IO;
+    }
+    return result;
+}
+
+void csvkit_schema_release(csvkit_schema_t *schema) {
+    if (!schema) return;
+
+    free(schema->types);
+    free(schema->nullable);
+    memset(schema, 0, sizeof(*schema));
+}
@@ -0,0 +1,446 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Multi-threaded parsing of in-memory sources.
+ *
+ * The input is cut into chunks at the first line feed after every
+ * PARALLEL_CHUNK_SIZE bytes. Each chunk is parsed speculatively on a
+ * worker thread, assuming that line feed ends a row; a worker keeps
+ * parsing while its rows start before the next chunk's start. The
+ * consumer hands rows out in order and checks each guess: if the
+ * previous chunk's last row ran past a chunk's start (the line feed was
+ * inside a quoted field), that chunk's rows are discarded and its range
+ * is parsed again sequentially from the true row boundary.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "parser_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define PARALLEL_CHUNK_SIZE (1024 * 1024)
+#define MAX_PARALLEL_THREADS 64
+
+/* A row parsed by a worker */
+typedef struct {
+    size_t start;                 /* Input offset of the row */
+    size_t end;                   /* Input offset just past the row */
+    size_t first_span;            /* Index of its first span in the chunk */
+    size_t arena_start;           /* Start of its unescaped bytes */
+    size_t field_total;
+    bool skipped_data;
+} chunk_row_t;
+
+typedef struct {
+    size_t seq;                   /* Chunk number held by this slot */
+    bool done;
+
+    size_t start;                 /* Speculative first row start */
+    size_t limit;                 /* Rows starting at or past this belong to the next chunk */
+    size_t end;                   /* Offset past the last parsed row */
+    csvkit_error_t error;         /* Error that stopped the chunk, if any */
+    size_t error_pos;             /* Input position after the failed row */
+
+    chunk_row_t *rows;
+    size_t row_count;
+    size_t row_capacity;
+    size_t cursor;                /* Next row to deliver */
+    field_span_t *spans;
+    size_t span_count;
+    size_t span_capacity;
+    char *arena;
+    size_t arena_len;
+    size_t arena_capacity;
+} parse_chunk_t;
+
+struct csvkit_parallel {
+    size_t *starts;               /* Speculative start of every chunk */
+    size_t chunk_count;
+
+    parse_chunk_t *slots;         /* Ring of chunks in flight */
+    size_t slot_count;
+
+    pthread_t *threads;
+    csvkit_parser_t **workers;    /* Private parser per thread */
+    size_t worker_count;
+    size_t thread_count;          /* Threads actually running */
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;    /* A slot was freed or stop was set */
+    pthread_cond_t chunk_done;
+    size_t next_claim;            /* Next chunk for a worker to take */
+    size_t deliver;               /* Chunk being delivered */
+    bool stop;
+
+    size_t pos;                   /* True start of the next undelivered row */
+    bool fixup;                   /* Re-parsing the current chunk sequentially */
+};
+
+static bool grow_array(void **array, size_t *capacity, size_t needed, size_t elem_size) {
+    if (needed <= *capacity) return true;
+
+    size_t new_capacity = *capacity ? *capacity : INITIAL_FIELD_COUNT;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    void *new_array = realloc(*array, new_capacity * elem_size);
+    if (!new_array) return false;
+
+    *array = new_array;
+    *capacity = new_capacity;
+    return true;
+}
+
+/* Drop the structural index; it may not cover the next parse position */
+static void reset_index(csvkit_parser_t *parser) {
+    parser->index_count = 0;
+    parser->index_pos = 0;
+    parser->index_end = 0;
+}
+
+/* Copy the row just parsed by `worker` into the chunk */
+static bool store_row(parse_chunk_t *chunk, const csvkit_parser_t *worker) {
+    if (!grow_array((void **)&chunk->rows, &chunk->row_capacity,
+                    chunk->row_count + 1, sizeof(chunk_row_t)) ||
+        !grow_array((void **)&chunk->spans, &chunk->span_capacity,
+                    chunk->span_count + worker->span_count, sizeof(field_span_t)) ||
+        !grow_array((void **)&chunk->arena, &chunk->arena_capacity,
+                    chunk->arena_len + worker->arena_len, 1)) {
+        return false;
+    }
+
+    chunk_row_t *row = &chunk->rows[chunk->row_count++];
+    row->start = worker->row_start;
+    row->end = worker->input_pos;
+    row->first_span = chunk->span_count;
+    row->arena_start = chunk->arena_len;
+    row->field_total = worker->field_total;
+    row->skipped_data = worker->skipped_data;
+
+    memcpy(chunk->spans + chunk->span_count, worker->spans,
+           worker->span_count * sizeof(field_span_t));
+    chunk->span_count += worker->span_count;
+    if (worker->arena_len > 0) {
+        memcpy(chunk->arena + chunk->arena_len, worker->arena, worker->arena_len);
+        chunk->arena_len += worker->arena_len;
+    }
+    return true;
+}
+
+static void parse_chunk(csvkit_parser_t *worker, parse_chunk_t *chunk) {
+    chunk->row_count = 0;
+    chunk->span_count = 0;
+    chunk->arena_len = 0;
+    chunk->cursor = 0;
+    chunk->error = CSVKIT_OK;
+
+    reset_index(worker);
+    worker->input_pos = chunk->start;
+
+    while (worker->input_pos < chunk->limit) {
+        csvkit_error_t result = csvkit_parse_raw_row(worker);
+        if (result == CSVKIT_ERROR_EOF) break;
+        if (result == CSVKIT_OK && !store_row(chunk, worker)) {
+            result = CSVKIT_ERROR_MEMORY;
+        }
+        if (result != CSVKIT_OK) {
+            chunk->error = result;
+            chunk->error_pos = worker->input_pos;
+            break;
+        }
+    }
+
+    chunk->end = worker->input_pos;
+}
+
+typedef struct {
+    csvkit_parallel_t *par;
+    csvkit_parser_t *worker;
+} worker_arg_t;
+
+static void *worker_main(void *arg) {
+    csvkit_parallel_t *par = ((worker_arg_t *)arg)->par;
+    csvkit_parser_t *worker = ((worker_arg_t *)arg)->worker;
+    free(arg);
+
+    pthread_mutex_lock(&par->lock);
+    for (;;) {
+        while (!par->stop &&
+               (par->next_claim >= par->chunk_count ||
+                par->next_claim >= par->deliver + par->slot_count)) {
+            pthread_cond_wait(&par->work_ready, &par->lock);
+        }
+        if (par->stop) break;
+
+        size_t seq = par->next_claim++;
+        parse_chunk_t *chunk = &par->slots[seq % par->slot_count];
+        chunk->start = par->starts[seq];
+        chunk->limit = seq + 1 < par->chunk_count ? par->starts[seq + 1] : worker->string_len;
+        pthread_mutex_unlock(&par->lock);
+
+        parse_chunk(worker, chunk);
+
+        pthread_mutex_lock(&par->lock);
+        chunk->seq = seq;
+        chunk->done = true;
+        pthread_cond_broadcast(&par->chunk_done);
+    }
+    pthread_mutex_unlock(&par->lock);
+
+    return NULL;
+}
+
+static void free_parallel(csvkit_parallel_t *par) {
+    for (size_t i = 0; par->slots && i < par->slot_count; i++) {
+        free(par->slots[i].rows);
+        free(par->slots[i].spans);
+        free(par->slots[i].arena);
+    }
+    for (size_t i = 0; i < par->worker_count; i++) {
+        csvkit_parser_free(par->workers[i]);
+    }
+    free(par->slots);
+    free(par->workers);
+    free(par->threads);
+    free(par->starts);
+    free(par);
+}
+
+/* Choose speculative chunk starts from `begin` to the end of the input */
+static bool split_chunks(csvkit_parallel_t *par, const char *input, size_t begin, size_t len) {
+    size_t capacity = (len - begin) / PARALLEL_CHUNK_SIZE + 1;
+    par->starts = malloc(capacity * sizeof(size_t));
+    if (!par->starts) return false;
+
+    par->starts[0] = begin;
+    par->chunk_count = 1;
+
+    size_t boundary = begin + PARALLEL_CHUNK_SIZE;
+    while (boundary < len && par->chunk_count < capacity) {
+        const char *lf = memchr(input + boundary, '\n', len - boundary);
+        if (!lf || (size_t)(lf - input) + 1 >= len) break;
+
+        size_t start = (size_t)(lf - input) + 1;
+        par->starts[par->chunk_count++] = start;
+        boundary = start + PARALLEL_CHUNK_SIZE;
+    }
+
+    return true;
+}
+
+bool csvkit_parallel_start(csvkit_parser_t *parser) {
+    size_t thread_count = parser->config.threads;
+    if (thread_count > MAX_PARALLEL_THREADS) {
+        thread_count = MAX_PARALLEL_THREADS;
+    }
+    if (thread_count < 2 || parser->source_type != SOURCE_STRING) return false;
+    if (parser->input_len - parser->input_pos < 2 * PARALLEL_CHUNK_SIZE) return false;
+
+    csvkit_parallel_t *par = calloc(1, sizeof(csvkit_parallel_t));
+    if (!par) return false;
+
+    if (!split_chunks(par, parser->input, parser->input_pos, parser->input_len) ||
+        par->chunk_count < 2) {
+        free(par->starts);
+        free(par);
+        return false;
+    }
+
+    par->slot_count = 2 * thread_count;
+    par->slots = calloc(par->slot_count, sizeof(parse_chunk_t));
+    par->threads = calloc(thread_count, sizeof(pthread_t));
+    par->workers = calloc(thread_count, sizeof(csvkit_parser_t *));
+    if (!par->slots || !par->threads || !par->workers) {
+        free_parallel(par);
+        return false;
+    }
+
+    /* Workers parse with the same rules, and the projection resolved by
+     * the parser, but never read a header or recurse into threads. Typed
+     * conversion happens when rows are delivered. */
+    csvkit_config_t worker_config = parser->config;
+    worker_config.threads = 0;
+    worker_config.has_header = false;
+    worker_config.columns = parser->projecting ? parser->projection : NULL;
+    worker_config.column_count = parser->projecting ? parser->projected_count : 0;
+    worker_config.column_names = NULL;
+    worker_config.column_name_count = 0;
+    worker_config.schema = NULL;
+    worker_config.schema_count = 0;
+    for (size_t i = 0; i < thread_count; i++) {
+        par->workers[i] = csvkit_parser_new_with_config(&worker_config);
+        if (!par->workers[i]) {
+            free_parallel(par);
+            return false;
+        }
+        csvkit_open_string(par->workers[i], parser->input, parser->input_len);
+        par->worker_count++;
+    }
+
+    pthread_mutex_init(&par->lock, NULL);
+    pthread_cond_init(&par->work_ready, NULL);
+    pthread_cond_init(&par->chunk_done, NULL);
+    par->pos = parser->input_pos;
+
+    size_t started = 0;
+    for (; started < thread_count; started++) {
+        worker_arg_t *arg = malloc(sizeof(worker_arg_t));
+        if (!arg) break;
+        arg->par = par;
+        arg->worker = par->workers[started];
+        if (pthread_create(&par->threads[started], NULL, worker_main, arg) != 0) {
+            free(arg);
+            break;
+        }
+    }
+
+    /* Fewer threads than asked for still work; only join those started */
+    par->thread_count = started;
+    parser->parallel = par;
+    if (started == 0) {
+        csvkit_parallel_stop(parser);
+        return false;
+    }
+
+    return true;
+}
+
+void csvkit_parallel_stop(csvkit_parser_t *parser) {
+    csvkit_parallel_t *par = parser->parallel;
+    if (!par) return;
+
+    pthread_mutex_lock(&par->lock);
+    par->stop = true;
+    pthread_cond_broadcast(&par->work_ready);
+    pthread_mutex_unlock(&par->lock);
+
+    for (size_t i = 0; i < par->thread_count; i++) {
+        pthread_join(par->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&par->chunk_done);
+    pthread_cond_destroy(&par->work_ready);
+    pthread_mutex_destroy(&par->lock);
+
+    free_parallel(par);
+    parser->parallel = NULL;
+}
+
+static parse_chunk_t *wait_chunk(csvkit_parallel_t *par, size_t seq) {
+    parse_chunk_t *chunk = &par->slots[seq % par->slot_count];
+
+    pthread_mutex_lock(&par->lock);
+    while (!(chunk->done && chunk->seq == seq)) {
+        pthread_cond_wait(&par->chunk_done, &par->lock);
+    }
+    pthread_mutex_unlock(&par->lock);
+
+    return chunk;
+}
+
+static void release_chunk(csvkit_parallel_t *par, parse_chunk_t *chunk) {
+    pthread_mutex_lock(&par->lock);
+    chunk->done = false;
+    par->deliver++;
+    par->fixup = false;
+    pthread_cond_broadcast(&par->work_ready);
+    pthread_mutex_unlock(&par->lock);
+}
+
+/* Hand a stored row to the parser as if it had just been parsed */
+static bool deliver_row(csvkit_parser_t *parser, parse_chunk_t *chunk) {
+    const chunk_row_t *row = &chunk->rows[chunk->cursor++];
+    bool last = chunk->cursor == chunk->row_count;
+    size_t span_end = last ? chunk->span_count : row[1].first_span;
+    size_t arena_end = last ? chunk->arena_len : row[1].arena_start;
+    size_t span_count = span_end - row->first_span;
+    size_t arena_len = arena_end - row->arena_start;
+
+    if (!grow_array((void **)&parser->spans, &parser->span_capacity,
+                    span_count, sizeof(field_span_t)) ||
+        !grow_array((void **)&parser->arena, &parser->arena_capacity, arena_len, 1)) {
+        return false;
+    }
+
+    memcpy(parser->spans, chunk->spans + row->first_span, span_count * sizeof(field_span_t));
+    if (arena_len > 0) {
+        memcpy(parser->arena, chunk->arena + row->arena_start, arena_len);
+    }
+    parser->span_count = span_count;
+    parser->arena_len = arena_len;
+    parser->field_total = row->field_total;
+    parser->skipped_data = row->skipped_data;
+    parser->row_start = row->start;
+    parser->input_pos = row->end;
+    return true;
+}
+
+csvkit_error_t csvkit_parallel_next_row(csvkit_parser_t *parser) {
+    csvkit_parallel_t *par = parser->parallel;
+    csvkit_error_t result;
+
+    for (;;) {
+        if (par->deliver >= par->chunk_count) {
+            /* Everything delivered - finish (and report EOF) sequentially */
+            parser->input_pos = par->pos;
+            reset_index(parser);
+            csvkit_parallel_stop(parser);
+            return csvkit_parse_raw_row(parser);
+        }
+
+        parse_chunk_t *chunk = wait_chunk(par, par->deliver);
+
+        if (par->fixup || chunk->start != par->pos) {
+            /* Wrong guess: the previous row ran past this chunk's start */
+            if (!par->fixup) {
+                par->fixup = true;
+                parser->input_pos = par->pos;
+                reset_index(parser);
+            }
+
+            if (parser->input_pos < chunk->limit) {
+                result = csvkit_parse_raw_row(parser);
+                if (result == CSVKIT_OK) return CSVKIT_OK;
+
+                /* Continue sequentially from wherever the error left us */
+                csvkit_parallel_stop(parser);
+                return result;
+            }
+
+            par->pos = parser->input_pos;
+            release_chunk(par, chunk);
+            continue;
+        }
+
+        if (chunk->cursor < chunk->row_count) {
+            if (!deliver_row(parser, chunk)) {
+                parser->input_pos = chunk->rows[chunk->cursor - 1].start;
+                reset_index(parser);
+                csvkit_parallel_stop(parser);
+                return CSVKIT_ERROR_MEMORY;
+            }
+            return CSVKIT_OK;
+        }
+
+        if (chunk->error != CSVKIT_OK) {
+            result = chunk->error;
+            parser->input_pos = chunk->error_pos;
+            reset_index(parser);
+            csvkit_parallel_stop(parser);
+            return result;
+        }
+
+        par->pos = chunk->end;
+        release_chunk(par, chunk);
+    }
+}
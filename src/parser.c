@@ -9,35 +9,28 @@
  */
 
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE  /* madvise() and MADV_HUGEPAGE */
 
-#include "csvkit.h"
+#include "parser_internal.h"
+#include "scan.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#define INITIAL_BUFFER_SIZE 1024
-#define INITIAL_FIELD_COUNT 16
-
-typedef enum {
-    SOURCE_NONE,
-    SOURCE_FILE,
-    SOURCE_STREAM,
-    SOURCE_STRING
-} source_type_t;
-
-struct csvkit_parser {
-    csvkit_config_t config;
-    source_type_t source_type;
-    FILE *file;
-    const char *string_data;
-    size_t string_pos;
-    size_t string_len;
-    size_t row_number;
-    char *error_msg;
-    bool owns_file;
-    size_t expected_field_count;  /* For strict mode */
-};
+#ifdef CSVKIT_HAVE_FREADAHEAD
+#include <stdio_ext.h>  /* __freadahead() */
+#endif
+
+#define INDEX_WINDOW_SIZE (32 * 1024)
+#define INDEX_COOLDOWN_ROWS 64
+
+/* Bound on config.columns entries, which size the column map */
+#define MAX_PROJECTED_INDEX ((size_t)1 << 20)
 
 /* Internal helper functions */
 static char *string_duplicate(const char *str, size_t len) {
@@ -49,80 +42,385 @@ static char *string_duplicate(const char *str, size_t len) {
     return result;
 }
 
-static void trim_whitespace_inplace(char *str) {
-    if (!str || *str == '\0') return;
+static void set_error(csvkit_parser_t *parser, const char *msg) {
+    csvkit_set_error(parser, msg);
+}
+
+/* Reset the input window for a newly opened source */
+static void reset_input(csvkit_parser_t *parser, const char *data, size_t len, bool eof) {
+    parser->input = data;
+    parser->input_offset = 0;
+    parser->input_pos = 0;
+    parser->input_len = len;
+    parser->input_eof = eof;
+    parser->input_errno = 0;
+    parser->row_start = 0;
+    parser->index_count = 0;
+    parser->index_pos = 0;
+    parser->index_base = 0;
+    parser->index_end = 0;
+    parser->index_cooldown = 0;
+    parser->parallel_tried = false;
+    parser->readahead_tried = false;
+    parser->push_scanning = false;
+}
 
-    /* Trim leading - find first non-space */
-    char *start = str;
-    while (isspace((unsigned char)*start)) start++;
+/* glibc's flag for a get area holding pushed-back bytes (libio.h) */
+#define GLIBC_IO_IN_BACKUP 0x100
+
+size_t csvkit_stream_buffered(FILE *file) {
+#if defined(CSVKIT_HAVE_FREADAHEAD)
+    /* musl, and any other C library ./configure found it in */
+    return __freadahead(file);
+#elif defined(CSVKIT_GLIBC_FILE)
+    size_t n = (size_t)(file->_IO_read_end - file->_IO_read_ptr);
+    if (file->_flags & GLIBC_IO_IN_BACKUP) {
+        /* The main get area resumes after the pushed-back bytes */
+        n += (size_t)(file->_IO_save_end - file->_IO_save_base);
+    }
+    return n;
+#elif defined(CSVKIT_BSD_FILE)
+    size_t n = file->_r > 0 ? (size_t)file->_r : 0;
+    if (file->_ub._base != NULL && file->_ur > 0) {
+        n += (size_t)file->_ur;
+    }
+    return n;
+#else
+    (void)file;
+    return SIZE_MAX;
+#endif
+}
 
-    /* If all spaces, make empty string */
-    if (*start == '\0') {
-        *str = '\0';
-        return;
+/* One read() that returns whatever is available, or 0 at end of input */
+static size_t read_fd(int fd, char *dest, size_t len, int *error) {
+    ssize_t n;
+    do {
+        n = read(fd, dest, len);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        *error = errno;
+        return 0;
     }
+    return (size_t)n;
+}
 
-    /* Trim trailing - find last non-space (without strlen) */
-    char *end = start;
-    char *last_non_space = start;
+/* One read from a file or stream source (a csvkit_source_read_t). Like
+ * read(), it returns as soon as some input is available, so rows from a
+ * slow producer reach the parser without waiting for a full buffer. */
+static size_t read_source(void *context, char *dest, size_t len, int *error) {
+    csvkit_parser_t *parser = context;
 
-    while (*end != '\0') {
-        if (!isspace((unsigned char)*end)) {
-            last_non_space = end;
-        }
-        end++;
+    if (parser->source_type == SOURCE_FILE) {
+        return read_fd(parser->fd, dest, len, error);
     }
 
-    /* Copy in-place if needed (without memmove) */
-    if (start != str) {
-        char *dest = str;
-        char *src = start;
-        while (src <= last_non_space) {
-            *dest++ = *src++;
-        }
-        *dest = '\0';
-    } else {
-        /* Just null-terminate after last non-space */
-        last_non_space[1] = '\0';
+    /* Bytes stdio already holds come first; after them the descriptor is
+     * read directly, since fread() waits until it has all len bytes.
+     * Streams without a descriptor (fmemopen() and the like) never wait. */
+    size_t buffered = csvkit_stream_buffered(parser->file);
+    if (buffered == 0) {
+        int fd = fileno(parser->file);
+        if (fd >= 0) return read_fd(fd, dest, len, error);
+        buffered = len;
+    }
+    if (len > buffered) {
+        len = buffered;
+    }
+
+    size_t got = fread(dest, 1, len, parser->file);
+    if (got == 0 && ferror(parser->file)) {
+        *error = EIO;
     }
+    return got;
 }
 
-static void set_error(csvkit_parser_t *parser, const char *msg) {
-    free(parser->error_msg);
-    parser->error_msg = msg ? strdup(msg) : NULL;
+static bool alloc_input_buf(csvkit_parser_t *parser, size_t min_capacity) {
+    size_t capacity = parser->config.buffer_size ?
+        parser->config.buffer_size : DEFAULT_INPUT_BUFFER_SIZE;
+    if (capacity < min_capacity) {
+        capacity = min_capacity;
+    }
+    parser->input_buf = malloc(capacity);
+    if (!parser->input_buf) {
+        parser->input_eof = true;
+        parser->input_errno = ENOMEM;
+        return false;
+    }
+    parser->input_capacity = capacity;
+    return true;
+}
+
+/* Check the first bytes of a pipe or stream for compression. Plain bytes
+ * become the start of the input window; returns whether there were any. */
+static bool sniff_source(csvkit_parser_t *parser) {
+    unsigned char magic[4];
+    size_t len = 0;
+    int error = 0;
+
+    /* Stop as soon as the bytes rule compression out, so that a slow
+     * producer's first row is not held back */
+    do {
+        size_t got = read_source(parser, (char *)magic + len, sizeof(magic) - len, &error);
+        if (got == 0) break;
+        len += got;
+    } while (len < sizeof(magic) && csvkit_magic_prefix(magic, len));
+
+    if (error != 0) {
+        parser->input_errno = error;
+        parser->input_eof = true;
+        return false;
+    }
+
+    csvkit_compression_t format = csvkit_detect_compression(magic, len);
+    if (format != CSVKIT_COMPRESSION_NONE) {
+        parser->decoder = csvkit_decoder_new(format, (const char *)magic, len);
+        if (!parser->decoder) {
+            parser->input_errno = ENOMEM;
+            parser->input_eof = true;
+        }
+        return false;
+    }
+
+    if (len == 0) {
+        parser->input_eof = true;
+        return false;
+    }
+    if (parser->input_capacity < sizeof(magic)) {
+        free(parser->input_buf);
+        parser->input_buf = NULL;
+        parser->input_capacity = 0;
+        if (!alloc_input_buf(parser, sizeof(magic))) return false;
+    }
+    memcpy(parser->input_buf, magic, len);
+    parser->input = parser->input_buf;
+    parser->input_pos = 0;
+    parser->input_len = len;
+    parser->row_start = 0;
+    return true;
 }
 
-static int read_char(csvkit_parser_t *parser) {
-    switch (parser->source_type) {
-        case SOURCE_FILE:
-        case SOURCE_STREAM:
-            return fgetc(parser->file);
-        case SOURCE_STRING:
-            if (parser->string_pos >= parser->string_len) {
-                return EOF;
+/* Refill the input window with one bulk read from the file or stream.
+ * The unfinished row from row_start onward is moved to the front of the
+ * buffer first, growing the buffer if the row fills it completely.
+ * Returns false once the source is exhausted or a read fails. */
+static bool fill_input(csvkit_parser_t *parser) {
+    /* Push sources only grow through csvkit_feed() */
+    if (parser->source_type == SOURCE_PUSH) {
+        parser->push_starved = !parser->input_eof;
+        return false;
+    }
+    if (parser->input_eof) return false;
+
+    if (parser->sniff_pending) {
+        parser->sniff_pending = false;
+        if (sniff_source(parser)) return true;
+        if (parser->input_eof) return false;
+    }
+
+    /* Overlap reads with parsing on an I/O thread; compressed input is
+     * always decompressed there */
+    if ((parser->config.read_ahead > 0 || parser->decoder) && !parser->readahead &&
+        !parser->readahead_tried) {
+        parser->readahead_tried = true;
+        csvkit_readahead_start(parser);
+    }
+    if (parser->readahead) {
+        return csvkit_readahead_fill(parser);
+    }
+
+    size_t keep = 0;
+    if (!parser->input_buf) {
+        if (!alloc_input_buf(parser, 0)) return false;
+    } else if (parser->input == parser->input_buf) {
+        parser->input_offset += parser->row_start;
+        keep = parser->input_len - parser->row_start;
+        if (keep > 0 && parser->row_start > 0) {
+            memmove(parser->input_buf, parser->input_buf + parser->row_start, keep);
+        }
+        if (keep == parser->input_capacity) {
+            char *new_buf = realloc(parser->input_buf, parser->input_capacity * 2);
+            if (!new_buf) {
+                parser->input_eof = true;
+                parser->input_errno = ENOMEM;
+                return false;
             }
-            return (unsigned char)parser->string_data[parser->string_pos++];
-        default:
-            return EOF;
+            parser->input_buf = new_buf;
+            parser->input_capacity *= 2;
+        }
+    }
+
+    char *dest = parser->input_buf + keep;
+    size_t space = parser->input_capacity - keep;
+    int error = 0;
+    size_t got = parser->decoder ?
+        csvkit_decoder_read(parser->decoder, dest, space, read_source, parser, &error) :
+        read_source(parser, dest, space, &error);
+    parser->input_errno = error;
+
+    parser->input = parser->input_buf;
+    parser->input_pos = keep;
+    parser->input_len = keep + got;
+    parser->row_start = 0;
+    if (got == 0) {
+        parser->input_eof = true;
+        return false;
     }
+    return true;
+}
+
+static inline int read_char(csvkit_parser_t *parser) {
+    if (parser->input_pos >= parser->input_len && !fill_input(parser)) {
+        return EOF;
+    }
+    return (unsigned char)parser->input[parser->input_pos++];
 }
 
-static void unread_char(csvkit_parser_t *parser, int c) {
+/* Push back the character just returned by read_char(). A refill never
+ * happens between the two calls, so stepping back is always valid. */
+static inline void unread_char(csvkit_parser_t *parser, int c) {
     if (c == EOF) return;
+    if (parser->input_pos > 0) {
+        parser->input_pos--;
+    }
+}
 
-    switch (parser->source_type) {
-        case SOURCE_FILE:
-        case SOURCE_STREAM:
-            ungetc(c, parser->file);
-            break;
-        case SOURCE_STRING:
-            if (parser->string_pos > 0) {
-                parser->string_pos--;
-            }
-            break;
-        default:
-            break;
+/* Make room for at least `needed` bytes in the arena */
+static bool reserve_arena(csvkit_parser_t *parser, size_t needed) {
+    if (needed <= parser->arena_capacity) return true;
+
+    size_t new_capacity = parser->arena_capacity ? parser->arena_capacity : INITIAL_BUFFER_SIZE;
+    while (needed > new_capacity) {
+        new_capacity *= 2;
+    }
+    char *new_arena = realloc(parser->arena, new_capacity);
+    if (!new_arena) return false;
+
+    parser->arena = new_arena;
+    parser->arena_capacity = new_capacity;
+    return true;
+}
+
+/* Append n input bytes at row offset `offset` to the current field. The
+ * field stays a zero-copy slice while its bytes are contiguous in the
+ * input; otherwise (an unescaped quote, say) it moves into the arena. */
+static bool append_span(csvkit_parser_t *parser, field_span_t *field, size_t offset, size_t n) {
+    const char *row = parser->input + parser->row_start;
+
+    /* Fields outside the projection are only measured */
+    if (parser->skip_field) {
+        if (field->len == 0) {
+            field->offset = offset;
+        }
+        field->len += n;
+        return true;
+    }
+
+    if (!field->copied) {
+        if (field->len == 0) {
+            field->offset = offset;
+            field->len = n;
+            return true;
+        }
+        if (field->offset + field->len == offset) {
+            field->len += n;
+            return true;
+        }
+        if (!reserve_arena(parser, parser->arena_len + field->len + n)) {
+            return false;
+        }
+        memcpy(parser->arena + parser->arena_len, row + field->offset, field->len);
+        field->offset = parser->arena_len;
+        field->copied = true;
+        parser->arena_len += field->len;
+    } else if (!reserve_arena(parser, parser->arena_len + n)) {
+        return false;
+    }
+
+    memcpy(parser->arena + parser->arena_len, row + offset, n);
+    parser->arena_len += n;
+    field->len += n;
+    return true;
+}
+
+static inline size_t column_slot(const csvkit_parser_t *parser, size_t column) {
+    return column < parser->column_map_len ? parser->column_map[column] : NO_COLUMN;
+}
+
+/* Start parsing a row at input_pos */
+static void begin_row(csvkit_parser_t *parser) {
+    parser->arena_len = 0;
+    parser->row_start = parser->input_pos;
+    parser->field_total = 0;
+    parser->skipped_data = false;
+
+    if (parser->projecting) {
+        /* Projected columns missing from the row stay empty */
+        memset(parser->spans, 0, parser->projected_count * sizeof(field_span_t));
+        parser->span_count = parser->projected_count;
+        parser->skip_field = column_slot(parser, 0) == NO_COLUMN;
+    } else {
+        parser->span_count = 0;
+        parser->skip_field = false;
+    }
+}
+
+static bool is_blank(const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!isspace((unsigned char)data[i])) return false;
+    }
+    return true;
+}
+
+/* Finish the current field, trimming unquoted fields if configured */
+static bool push_field(csvkit_parser_t *parser, field_span_t *field, bool was_quoted) {
+    size_t slot = parser->span_count;
+
+    if (parser->projecting) {
+        slot = column_slot(parser, parser->field_total);
+        parser->skip_field = column_slot(parser, parser->field_total + 1) == NO_COLUMN;
+    }
+    parser->field_total++;
+
+    if (slot == NO_COLUMN) {
+        /* Skipped fields only matter for empty-row detection */
+        if (!parser->skipped_data && field->len > 0) {
+            parser->skipped_data = was_quoted || !parser->config.trim_whitespace ||
+                                   !is_blank(csvkit_span_data(parser, field), field->len);
+        }
+        field->offset = 0;
+        field->len = 0;
+        field->copied = false;
+        return true;
+    }
+
+    if (parser->config.trim_whitespace && !was_quoted) {
+        const char *data = csvkit_span_data(parser, field);
+        while (field->len > 0 && isspace((unsigned char)data[0])) {
+            data++;
+            field->offset++;
+            field->len--;
+        }
+        while (field->len > 0 && isspace((unsigned char)data[field->len - 1])) {
+            field->len--;
+        }
     }
+
+    if (parser->projecting) {
+        parser->spans[slot] = *field;
+    } else {
+        if (parser->span_count >= parser->span_capacity) {
+            size_t new_capacity = parser->span_capacity ? parser->span_capacity * 2 : INITIAL_FIELD_COUNT;
+            field_span_t *new_spans = realloc(parser->spans, new_capacity * sizeof(field_span_t));
+            if (!new_spans) return false;
+            parser->spans = new_spans;
+            parser->span_capacity = new_capacity;
+        }
+        parser->spans[parser->span_count++] = *field;
+    }
+    field->offset = 0;
+    field->len = 0;
+    field->copied = false;
+    return true;
 }
 
 /* Validate configuration for invalid combinations */
@@ -156,9 +454,121 @@ static bool validate_config(const csvkit_config_t *config) {
         return false;
     }
 
+    /* Project by indexes or by names, not both; names need a header */
+    if (config->column_count > 0 && !config->columns) {
+        return false;
+    }
+    for (size_t i = 0; i < config->column_count; i++) {
+        /* column_map has an entry for every column up to the highest index */
+        if (config->columns[i] >= MAX_PROJECTED_INDEX) return false;
+    }
+    if (config->column_name_count > 0) {
+        if (!config->column_names || config->column_count > 0 || !config->has_header) {
+            return false;
+        }
+        for (size_t i = 0; i < config->column_name_count; i++) {
+            if (!config->column_names[i]) return false;
+            for (size_t j = 0; j < i; j++) {
+                if (strcmp(config->column_names[i], config->column_names[j]) == 0) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    /* Every schema entry must be a known type */
+    if (config->schema_count > 0) {
+        if (!config->schema) return false;
+        for (size_t i = 0; i < config->schema_count; i++) {
+            if ((unsigned)config->schema[i] > CSVKIT_TYPE_TIMESTAMP) return false;
+        }
+    }
+
+    return true;
+}
+
+/* Build column_map from the projected column indexes. Fails if a column
+ * is selected twice. */
+static bool build_column_map(csvkit_parser_t *parser) {
+    size_t map_len = 0;
+    for (size_t i = 0; i < parser->projected_count; i++) {
+        if (parser->projection[i] >= map_len) {
+            map_len = parser->projection[i] + 1;
+        }
+    }
+
+    size_t *map = realloc(parser->column_map, map_len * sizeof(size_t));
+    if (!map) return false;
+    parser->column_map = map;
+    parser->column_map_len = map_len;
+
+    for (size_t i = 0; i < map_len; i++) {
+        map[i] = NO_COLUMN;
+    }
+    for (size_t i = 0; i < parser->projected_count; i++) {
+        if (map[parser->projection[i]] != NO_COLUMN) return false;
+        map[parser->projection[i]] = i;
+    }
+
+    /* Projected rows always have projected_count spans */
+    if (parser->span_capacity < parser->projected_count) {
+        field_span_t *spans = realloc(parser->spans, parser->projected_count * sizeof(field_span_t));
+        if (!spans) return false;
+        parser->spans = spans;
+        parser->span_capacity = parser->projected_count;
+    }
+
+    return true;
+}
+
+/* Take private copies of the config's projection arrays; the caller's
+ * arrays need not outlive parser creation */
+static bool copy_projection(csvkit_parser_t *parser, const csvkit_config_t *config) {
+    size_t count = config->column_count ? config->column_count : config->column_name_count;
+
+    parser->config.columns = NULL;
+    parser->config.column_names = NULL;
+    if (count == 0) return true;
+
+    parser->projection = malloc(count * sizeof(size_t));
+    if (!parser->projection) return false;
+    parser->projected_count = count;
+
+    if (config->column_count > 0) {
+        memcpy(parser->projection, config->columns, count * sizeof(size_t));
+        return build_column_map(parser);
+    }
+
+    parser->column_names = calloc(count, sizeof(char *));
+    if (!parser->column_names) return false;
+    for (size_t i = 0; i < count; i++) {
+        parser->column_names[i] = strdup(config->column_names[i]);
+        if (!parser->column_names[i]) return false;
+    }
+    return true;
+}
+
+static bool copy_schema(csvkit_parser_t *parser, const csvkit_config_t *config) {
+    parser->config.schema = NULL;
+    if (config->schema_count == 0) return true;
+
+    parser->schema = malloc(config->schema_count * sizeof(csvkit_type_t));
+    if (!parser->schema) return false;
+    memcpy(parser->schema, config->schema, config->schema_count * sizeof(csvkit_type_t));
     return true;
 }
 
+/* Reset row numbering and header state for a newly opened source */
+static void reset_rows(csvkit_parser_t *parser) {
+    parser->row_number = 0;
+    parser->expected_field_count = 0;
+    parser->header_pending = parser->config.has_header;
+    parser->header_row = 0;
+
+    /* Header names are resolved again for every source */
+    parser->projecting = parser->projected_count > 0 && !parser->column_names;
+}
+
 csvkit_config_t csvkit_config_default(void) {
     csvkit_config_t config = {
         .delimiter = ',',
@@ -166,7 +576,24 @@ csvkit_config_t csvkit_config_default(void) {
         .escape_char = '"',
         .trim_whitespace = false,
         .skip_empty_rows = false,
-        .strict_mode = false
+        .strict_mode = false,
+        .buffer_size = 0,
+        .use_mmap = false,
+        .structural_index = false,
+        .threads = 0,
+        .read_ahead = 0,
+        .direct_io = false,
+        .decompress = true,
+        .compression = CSVKIT_COMPRESSION_NONE,
+        .compression_level = 0,
+        .compression_threads = 0,
+        .has_header = false,
+        .columns = NULL,
+        .column_count = 0,
+        .column_names = NULL,
+        .column_name_count = 0,
+        .schema = NULL,
+        .schema_count = 0
     };
     return config;
 }
@@ -188,6 +615,12 @@ csvkit_parser_t *csvkit_parser_new_with_config(const csvkit_config_t *config) {
     parser->source_type = SOURCE_NONE;
     parser->row_number = 0;
     parser->error_msg = NULL;
+    parser->fd = -1;
+
+    if (!copy_projection(parser, config) || !copy_schema(parser, config)) {
+        csvkit_parser_free(parser);
+        return NULL;
+    }
 
     return parser;
 }
@@ -196,27 +629,144 @@ void csvkit_parser_free(csvkit_parser_t *parser) {
     if (!parser) return;
 
     csvkit_close(parser);
+    free(parser->input_buf);
+    free(parser->spans);
+    free(parser->arena);
+    free(parser->views);
+    free(parser->index);
+    free(parser->projection);
+    free(parser->column_map);
+    free(parser->schema);
+    free(parser->values);
+    csvkit_header_free(parser->header);
+    if (parser->column_names) {
+        for (size_t i = 0; i < parser->projected_count; i++) {
+            free(parser->column_names[i]);
+        }
+        free(parser->column_names);
+    }
     free(parser->error_msg);
     free(parser);
 }
 
+static int open_readonly(csvkit_parser_t *parser, const char *filename) {
+    int fd;
+    do {
+        fd = open(filename, O_RDONLY);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        set_error(parser, strerror(errno));
+    }
+    return fd;
+}
+
+/* Map the regular file behind fd read-only and parse it as a string source.
+ * Returns false with errno set when the file cannot be mapped. */
+static bool map_file(csvkit_parser_t *parser, int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    if (!S_ISREG(st.st_mode)) {
+        errno = ENODEV;
+        return false;
+    }
+    if ((unsigned long long)st.st_size > (size_t)-1) {
+        errno = EFBIG;
+        return false;
+    }
+
+    size_t len = (size_t)st.st_size;
+    void *addr = NULL;
+    if (len > 0) {
+        addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) return false;
+
+        /* Hints only - failures are harmless */
+        madvise(addr, len, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+        madvise(addr, len, MADV_HUGEPAGE);
+#endif
+    }
+
+    parser->map_addr = addr;
+    parser->map_len = len;
+    parser->string_data = addr ? (const char *)addr : "";
+    parser->string_len = len;
+    parser->source_type = SOURCE_STRING;
+    reset_rows(parser);
+    reset_input(parser, parser->string_data, len, true);
+
+    return true;
+}
+
+/* Compression of a regular file, from its first bytes. Other files are
+ * checked by their first read instead (sniff_pending). */
+static csvkit_compression_t file_compression(int fd, bool *checked) {
+    struct stat st;
+    unsigned char magic[4];
+    *checked = false;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return CSVKIT_COMPRESSION_NONE;
+
+    *checked = true;
+    ssize_t n;
+    do {
+        n = pread(fd, magic, sizeof(magic), 0);
+    } while (n < 0 && errno == EINTR);
+    return n > 0 ? csvkit_detect_compression(magic, (size_t)n) : CSVKIT_COMPRESSION_NONE;
+}
+
 csvkit_error_t csvkit_open_file(csvkit_parser_t *parser, const char *filename) {
     if (!parser || !filename) return CSVKIT_ERROR_INVALID_ARG;
 
     csvkit_close(parser);
 
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        set_error(parser, strerror(errno));
-        return CSVKIT_ERROR_IO;
+    int fd = open_readonly(parser, filename);
+    if (fd < 0) return CSVKIT_ERROR_IO;
+
+    bool checked = true;
+    csvkit_compression_t format = parser->config.decompress ? file_compression(fd, &checked) :
+                                                              CSVKIT_COMPRESSION_NONE;
+
+    /* Pipes, unmappable and compressed files fall back to buffered reads */
+    if (format == CSVKIT_COMPRESSION_NONE && parser->config.use_mmap && map_file(parser, fd)) {
+        close(fd);
+        return CSVKIT_OK;
+    }
+
+    if (format != CSVKIT_COMPRESSION_NONE) {
+        parser->decoder = csvkit_decoder_new(format, NULL, 0);
+        if (!parser->decoder) {
+            close(fd);
+            set_error(parser, "Out of memory");
+            return CSVKIT_ERROR_MEMORY;
+        }
     }
 
-    parser->file = file;
+    parser->fd = fd;
     parser->source_type = SOURCE_FILE;
     parser->owns_file = true;
-    parser->row_number = 0;
-    parser->expected_field_count = 0;
+    parser->sniff_pending = !checked;
+    reset_rows(parser);
+    reset_input(parser, NULL, 0, false);
+
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_open_mmap(csvkit_parser_t *parser, const char *filename) {
+    if (!parser || !filename) return CSVKIT_ERROR_INVALID_ARG;
+
+    csvkit_close(parser);
+
+    int fd = open_readonly(parser, filename);
+    if (fd < 0) return CSVKIT_ERROR_IO;
+
+    if (!map_file(parser, fd)) {
+        set_error(parser, strerror(errno));
+        close(fd);
+        return CSVKIT_ERROR_IO;
+    }
 
+    /* The mapping stays valid after the descriptor is closed */
+    close(fd);
     return CSVKIT_OK;
 }
 
@@ -228,8 +778,9 @@ csvkit_error_t csvkit_open_stream(csvkit_parser_t *parser, FILE *stream) {
     parser->file = stream;
     parser->source_type = SOURCE_STREAM;
     parser->owns_file = false;
-    parser->row_number = 0;
-    parser->expected_field_count = 0;
+    parser->sniff_pending = parser->config.decompress;
+    reset_rows(parser);
+    reset_input(parser, NULL, 0, false);
 
     return CSVKIT_OK;
 }
@@ -240,11 +791,25 @@ csvkit_error_t csvkit_open_string(csvkit_parser_t *parser, const char *data, siz
     csvkit_close(parser);
 
     parser->string_data = data;
-    parser->string_pos = 0;
     parser->string_len = len;
     parser->source_type = SOURCE_STRING;
-    parser->row_number = 0;
-    parser->expected_field_count = 0;
+    reset_rows(parser);
+    reset_input(parser, data, len, true);
+
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_open_push(csvkit_parser_t *parser, csvkit_row_callback_t callback,
+                                void *user_data) {
+    if (!parser) return CSVKIT_ERROR_INVALID_ARG;
+
+    csvkit_close(parser);
+
+    parser->source_type = SOURCE_PUSH;
+    parser->push_callback = callback;
+    parser->push_user_data = user_data;
+    reset_rows(parser);
+    reset_input(parser, parser->input_buf, 0, false);
 
     return CSVKIT_OK;
 }
@@ -252,32 +817,67 @@ csvkit_error_t csvkit_open_string(csvkit_parser_t *parser, const char *data, siz
 void csvkit_close(csvkit_parser_t *parser) {
     if (!parser) return;
 
-    if (parser->owns_file && parser->file) {
-        fclose(parser->file);
+    csvkit_parallel_stop(parser);
+    csvkit_readahead_stop(parser);
+    csvkit_decoder_free(parser->decoder);
+    parser->decoder = NULL;
+    parser->sniff_pending = false;
+
+    if (parser->owns_file && parser->fd >= 0) {
+        close(parser->fd);
+    }
+
+    if (parser->map_addr) {
+        munmap(parser->map_addr, parser->map_len);
     }
 
     parser->file = NULL;
+    parser->fd = -1;
+    parser->owns_file = false;
+    parser->map_addr = NULL;
+    parser->map_len = 0;
     parser->source_type = SOURCE_NONE;
     parser->string_data = NULL;
-    parser->string_pos = 0;
     parser->string_len = 0;
+    parser->push_callback = NULL;
+    parser->push_user_data = NULL;
+    reset_input(parser, NULL, 0, true);
 }
 
-/* Internal helper to parse a single row */
-static csvkit_error_t parse_row_internal(
-    csvkit_parser_t *parser,
-    csvkit_row_t *row,
-    char **buffer,
-    size_t *buffer_capacity,
-    size_t *fields_capacity
-) {
-    size_t buffer_len = 0;
+/* Internal helper to parse a single row into parser->spans */
+static csvkit_error_t parse_row_internal(csvkit_parser_t *parser) {
+    field_span_t field = {0, 0, false};
     bool in_quotes = false;
     bool field_started = false;
     bool field_was_quoted = false;
     int c;
 
-    while ((c = read_char(parser)) != EOF) {
+    begin_row(parser);
+
+    for (;;) {
+        /* Take runs of ordinary bytes straight from the input window.
+         * Inside quotes only the quote and escape characters are special;
+         * once an unquoted field has started only delimiters and line
+         * endings are. */
+        if ((in_quotes || field_started) && parser->input_pos < parser->input_len) {
+            const char *run = parser->input + parser->input_pos;
+            size_t avail = parser->input_len - parser->input_pos;
+            size_t run_len = in_quotes ?
+                csvkit_scan_run(run, avail, parser->config.quote_char,
+                                parser->config.escape_char, parser->config.escape_char) :
+                csvkit_scan_run(run, avail, parser->config.delimiter, '\r', '\n');
+
+            if (run_len > 0) {
+                if (!append_span(parser, &field, parser->input_pos - parser->row_start, run_len)) {
+                    return CSVKIT_ERROR_MEMORY;
+                }
+                parser->input_pos += run_len;
+                continue;
+            }
+        }
+
+        if ((c = read_char(parser)) == EOF) break;
+
         /* Handle CRLF outside quoted fields only */
         if (!in_quotes && c == '\r') {
             /* Skip CR, handle CRLF */
@@ -297,28 +897,9 @@ static csvkit_error_t parse_row_internal(
                 continue;
             } else if (c == parser->config.delimiter) {
                 /* End of field */
-                char *field_value = string_duplicate(*buffer, buffer_len);
-                if (!field_value) {
+                if (!push_field(parser, &field, field_was_quoted)) {
                     return CSVKIT_ERROR_MEMORY;
                 }
-
-                if (parser->config.trim_whitespace && !field_was_quoted) {
-                    trim_whitespace_inplace(field_value);
-                }
-
-                /* Resize fields array if needed */
-                if (row->field_count >= *fields_capacity) {
-                    *fields_capacity *= 2;
-                    char **new_fields = realloc(row->fields, *fields_capacity * sizeof(char *));
-                    if (!new_fields) {
-                        free(field_value);
-                        return CSVKIT_ERROR_MEMORY;
-                    }
-                    row->fields = new_fields;
-                }
-
-                row->fields[row->field_count++] = field_value;
-                buffer_len = 0;
                 field_started = false;
                 field_was_quoted = false;
                 continue;
@@ -331,12 +912,9 @@ static csvkit_error_t parse_row_internal(
             if (c == parser->config.escape_char) {
                 /* Escape character found - read next character */
                 int next = read_char(parser);
-                if (next == parser->config.quote_char) {
-                    /* Escaped quote: escape_char + quote becomes quote */
-                    c = parser->config.quote_char;
-                } else if (next == parser->config.escape_char) {
-                    /* Escaped escape character */
-                    c = parser->config.escape_char;
+                if (next == parser->config.quote_char || next == parser->config.escape_char) {
+                    /* Escaped quote or escape character: keep the second byte */
+                    c = next;
                 } else if (next != EOF) {
                     /* If escape_char == quote_char (RFC 4180 mode), treat as end of field */
                     if (parser->config.escape_char == parser->config.quote_char) {
@@ -354,21 +932,11 @@ static csvkit_error_t parse_row_internal(
                         in_quotes = false;
                         continue;
                     } else {
-                        /* Other escaped characters - add both escape and next char */
-                        /* First add escape char to buffer */
-                        if (buffer_len >= *buffer_capacity - 1) {
-                            *buffer_capacity *= 2;
-                            char *new_buffer = realloc(*buffer, *buffer_capacity);
-                            if (!new_buffer) {
-                                return CSVKIT_ERROR_MEMORY;
-                            }
-                            *buffer = new_buffer;
+                        /* Other escaped characters - keep both escape and next char */
+                        if (!append_span(parser, &field, parser->input_pos - 2 - parser->row_start, 2)) {
+                            return CSVKIT_ERROR_MEMORY;
                         }
-                        (*buffer)[buffer_len++] = c;
-
-                        /* Now set c to next char so it will be added in the next section */
-                        c = next;
-                        field_started = true;
+                        continue;
                     }
                 } else {
                     /* EOF after escape character */
@@ -392,22 +960,20 @@ static csvkit_error_t parse_row_internal(
             }
         }
 
-        /* Add character to buffer */
-        if (buffer_len >= *buffer_capacity - 1) {
-            *buffer_capacity *= 2;
-            char *new_buffer = realloc(*buffer, *buffer_capacity);
-            if (!new_buffer) {
-                return CSVKIT_ERROR_MEMORY;
-            }
-            *buffer = new_buffer;
+        /* Add the byte just read to the field */
+        if (!append_span(parser, &field, parser->input_pos - 1 - parser->row_start, 1)) {
+            return CSVKIT_ERROR_MEMORY;
         }
-
-        (*buffer)[buffer_len++] = c;
         field_started = true;
     }
 
+    /* A failed read ends the input early; report it rather than a short row */
+    if (c == EOF && parser->input_errno != 0) {
+        return parser->input_errno == ENOMEM ? CSVKIT_ERROR_MEMORY : CSVKIT_ERROR_IO;
+    }
+
     /* Handle last field */
-    if (c == EOF && buffer_len == 0 && row->field_count == 0 && !field_started) {
+    if (c == EOF && field.len == 0 && parser->field_total == 0 && !field_started) {
         return CSVKIT_ERROR_EOF;
     }
 
@@ -417,127 +983,846 @@ static csvkit_error_t parse_row_internal(
     }
 
     /* Add last field */
-    char *field_value = string_duplicate(*buffer, buffer_len);
-    if (!field_value) {
+    if (!push_field(parser, &field, field_was_quoted)) {
         return CSVKIT_ERROR_MEMORY;
     }
+    return CSVKIT_OK;
+}
 
-    if (parser->config.trim_whitespace && !field_was_quoted) {
-        trim_whitespace_inplace(field_value);
+/* Index the structural bytes of the window starting at `from`, which
+ * must lie outside quotes */
+static bool build_index(csvkit_parser_t *parser, size_t from) {
+    if (!parser->index) {
+        parser->index = malloc(INDEX_WINDOW_SIZE * sizeof(uint32_t));
+        if (!parser->index) return false;
     }
 
-    if (row->field_count >= *fields_capacity) {
-        (*fields_capacity)++;
-        char **new_fields = realloc(row->fields, *fields_capacity * sizeof(char *));
-        if (!new_fields) {
-            free(field_value);
-            return CSVKIT_ERROR_MEMORY;
-        }
-        row->fields = new_fields;
+    size_t len = parser->input_len - from;
+    if (len > INDEX_WINDOW_SIZE) {
+        len = INDEX_WINDOW_SIZE;
     }
 
-    row->fields[row->field_count++] = field_value;
-    return CSVKIT_OK;
+    parser->index_count = csvkit_index_structurals(parser->input + from, len,
+                                                   parser->config.delimiter,
+                                                   parser->config.quote_char,
+                                                   parser->index);
+    parser->index_pos = 0;
+    parser->index_base = from;
+    parser->index_end = from + len;
+    return true;
 }
 
-csvkit_error_t csvkit_read_row(csvkit_parser_t *parser, csvkit_row_t **out_row) {
-    if (!parser || !out_row) return CSVKIT_ERROR_INVALID_ARG;
-    if (parser->source_type == SOURCE_NONE) return CSVKIT_ERROR_INVALID_ARG;
+/* Find the first unquoted structural byte at or after `from` (a field
+ * start), or input_len if there is none. Returns SIZE_MAX if the field
+ * does not end within one index window. */
+static size_t next_structural(csvkit_parser_t *parser, size_t from) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        while (parser->index_pos < parser->index_count) {
+            size_t pos = parser->index_base + parser->index[parser->index_pos];
+            if (pos >= from) return pos;
+            parser->index_pos++;
+        }
 
-    *out_row = NULL;
+        if (parser->index_base <= from && parser->index_end >= parser->input_len) {
+            return parser->input_len;
+        }
 
-    csvkit_row_t *row;
-    size_t fields_capacity;
-    size_t buffer_capacity;
-    char *buffer;
-    csvkit_error_t result;
+        if (attempt > 0 || !build_index(parser, from)) break;
+    }
 
-read_next_row:
-    /* Allocate row structure */
-    row = calloc(1, sizeof(csvkit_row_t));
-    if (!row) {
-        set_error(parser, "Out of memory");
-        return CSVKIT_ERROR_MEMORY;
+    return SIZE_MAX;
+}
+
+/* Take input[begin, end) as a quoted field if it is exactly an RFC 4180
+ * quoted string: opening and closing quote with only doubled quotes in
+ * between. Unescaped content is copied into the arena. */
+static csvkit_error_t take_quoted_field(csvkit_parser_t *parser, size_t begin, size_t end,
+                                        field_span_t *field, bool *ok) {
+    const char quote = parser->config.quote_char;
+    const char *p = parser->input + begin + 1;
+    const char *stop = parser->input + end - 1;
+
+    *ok = false;
+    if (end - begin < 2 || *stop != quote) return CSVKIT_OK;
+
+    const char *q = memchr(p, quote, (size_t)(stop - p));
+    if (!q) {
+        field->offset = begin + 1 - parser->row_start;
+        field->len = (size_t)(stop - p);
+        *ok = true;
+        return CSVKIT_OK;
     }
 
-    /* Allocate initial fields array */
-    fields_capacity = INITIAL_FIELD_COUNT;
-    row->fields = malloc(fields_capacity * sizeof(char *));
-    if (!row->fields) {
-        free(row);
-        set_error(parser, "Out of memory");
-        return CSVKIT_ERROR_MEMORY;
+    /* Fields outside the projection are checked but not unescaped */
+    if (parser->skip_field) {
+        for (; q; q = memchr(q + 2, quote, (size_t)(stop - q - 2))) {
+            if (q + 1 >= stop || q[1] != quote) return CSVKIT_OK;
+        }
+        field->len = (size_t)(stop - p);
+        *ok = true;
+        return CSVKIT_OK;
     }
 
-    /* Allocate field buffer */
-    buffer_capacity = INITIAL_BUFFER_SIZE;
-    buffer = malloc(buffer_capacity);
-    if (!buffer) {
-        free(row->fields);
-        free(row);
-        set_error(parser, "Out of memory");
+    if (!reserve_arena(parser, parser->arena_len + (size_t)(stop - p))) {
         return CSVKIT_ERROR_MEMORY;
     }
 
-    /* Parse the row using the internal helper */
-    result = parse_row_internal(parser, row, &buffer, &buffer_capacity, &fields_capacity);
-
-    free(buffer);
+    field->offset = parser->arena_len;
+    field->copied = true;
+    field->len = 0;
 
-    if (result != CSVKIT_OK) {
-        /* Clean up on error */
-        for (size_t i = 0; i < row->field_count; i++) {
-            free(row->fields[i]);
+    for (;;) {
+        size_t run = q ? (size_t)(q - p) + 1 : (size_t)(stop - p);
+        if (q && (q + 1 >= stop || q[1] != quote)) {
+            parser->arena_len -= field->len;
+            return CSVKIT_OK;
         }
-        free(row->fields);
-        free(row);
+        memcpy(parser->arena + parser->arena_len, p, run);
+        parser->arena_len += run;
+        field->len += run;
+        if (!q) break;
+        p = q + 2;
+        q = memchr(p, quote, (size_t)(stop - p));
+    }
 
-        if (result == CSVKIT_ERROR_PARSE) {
-            set_error(parser, "Unclosed quoted field");
-        } else if (result == CSVKIT_ERROR_MEMORY) {
-            set_error(parser, "Out of memory");
+    *ok = true;
+    return CSVKIT_OK;
+}
+
+/* Second stage of indexed parsing: cut one row of an in-memory source
+ * into fields at the indexed structural positions. Each field must be
+ * plain or a well-formed quoted string; a stray quote means the index's
+ * quote parity cannot be trusted, so the row is re-parsed by the state
+ * machine and the index is dropped for a while. */
+static csvkit_error_t parse_row_indexed(csvkit_parser_t *parser) {
+    const char *input = parser->input;
+    const char quote = parser->config.quote_char;
+    csvkit_error_t result;
+
+    begin_row(parser);
+
+    if (parser->input_pos >= parser->input_len) {
+        return CSVKIT_ERROR_EOF;
+    }
+
+    size_t begin = parser->input_pos;
+    for (;;) {
+        size_t end = next_structural(parser, begin);
+        if (end == SIZE_MAX) goto fallback;
+
+        field_span_t field = {begin - parser->row_start, end - begin, false};
+        bool quoted = end > begin && input[begin] == quote;
+
+        if (quoted) {
+            /* The state machine owns quoted fields ending the input */
+            bool ok;
+            if (end >= parser->input_len) goto fallback;
+            result = take_quoted_field(parser, begin, end, &field, &ok);
+            if (result != CSVKIT_OK) return result;
+            if (!ok) goto fallback;
+        } else if (memchr(input + begin, quote, end - begin)) {
+            goto fallback;
         }
 
-        return result;
+        if (!push_field(parser, &field, quoted)) {
+            return CSVKIT_ERROR_MEMORY;
+        }
+
+        if (end >= parser->input_len) {
+            parser->input_pos = parser->input_len;
+            break;
+        }
+
+        begin = end + 1;
+        if (input[end] == parser->config.delimiter) continue;
+
+        /* Line ending: CRLF counts as one */
+        if (input[end] == '\r' && begin < parser->input_len && input[begin] == '\n') {
+            begin++;
+        }
+        parser->input_pos = begin;
+        break;
     }
 
-    /* Update row number */
-    parser->row_number++;
-    row->row_number = parser->row_number;
+    return CSVKIT_OK;
+
+fallback:
+    parser->input_pos = parser->row_start;
+    parser->index_count = 0;
+    parser->index_pos = 0;
+    parser->index_end = 0;
+    parser->index_cooldown = INDEX_COOLDOWN_ROWS;
+    return parse_row_internal(parser);
+}
+
+/* Parse a row of a push source. Rows are parsed as if the input were
+ * complete; a row found to run past the bytes fed so far is dropped and
+ * only parsed again once the scan in csvkit_push_row_ready() has seen its
+ * end, so long rows split into many chunks are not reparsed every time.
+ * Returns CSVKIT_ERROR_EOF while the row is incomplete. */
+static csvkit_error_t parse_row_pushed(csvkit_parser_t *parser) {
+    if (parser->push_scanning && !csvkit_push_row_ready(parser)) {
+        return CSVKIT_ERROR_EOF;
+    }
+
+    size_t start = parser->input_pos;
+    parser->push_starved = false;
+    csvkit_error_t result = parse_row_internal(parser);
+    if (parser->push_starved) {
+        parser->input_pos = start;
+        parser->push_scanning = false;
+        csvkit_push_row_ready(parser);
+        return CSVKIT_ERROR_EOF;
+    }
+    return result;
+}
+
+csvkit_error_t csvkit_parse_raw_row(csvkit_parser_t *parser) {
+    /* Indexed parsing needs the whole input in memory and quotes that are
+     * only escaped by doubling */
+    bool indexed = parser->config.structural_index &&
+                   parser->source_type == SOURCE_STRING &&
+                   parser->config.escape_char == parser->config.quote_char;
+
+    if (indexed && parser->index_cooldown == 0) {
+        return parse_row_indexed(parser);
+    }
+
+    if (parser->source_type == SOURCE_PUSH) {
+        return parse_row_pushed(parser);
+    }
+
+    if (parser->index_cooldown > 0) {
+        parser->index_cooldown--;
+    }
+    return parse_row_internal(parser);
+}
+
+static bool spans_are_empty(const csvkit_parser_t *parser) {
+    if (parser->skipped_data) return false;
+
+    for (size_t i = 0; i < parser->span_count; i++) {
+        if (parser->spans[i].len > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Set the error message for a failed csvkit_parse_raw_row() */
+static void report_row_error(csvkit_parser_t *parser, csvkit_error_t result) {
+    parser->span_count = 0;
+
+    if (result == CSVKIT_ERROR_PARSE) {
+        set_error(parser, "Unclosed quoted field");
+    } else if (result == CSVKIT_ERROR_MEMORY) {
+        set_error(parser, "Out of memory");
+    } else if (result == CSVKIT_ERROR_IO) {
+        const char *decode_error = csvkit_decoder_error(parser->decoder);
+        set_error(parser, decode_error ? decode_error : strerror(parser->input_errno));
+    }
+}
+
+/* Parse the next row into parser->spans, applying row numbering,
+ * empty-row skipping and strict-mode field count checks */
+static csvkit_error_t parse_next_row(csvkit_parser_t *parser) {
+    csvkit_error_t result;
+
+    for (;;) {
+        result = parser->parallel ? csvkit_parallel_next_row(parser) :
+                                    csvkit_parse_raw_row(parser);
+        if (result != CSVKIT_OK) {
+            report_row_error(parser, result);
+            return result;
+        }
 
-    /* Skip empty rows if configured */
-    if (parser->config.skip_empty_rows && csvkit_row_is_empty(row)) {
-        csvkit_row_free(row);
-        goto read_next_row;
+        /* Update row number */
+        parser->row_number++;
+
+        /* Skip empty rows if configured */
+        if (parser->config.skip_empty_rows && spans_are_empty(parser)) {
+            continue;
+        }
+        break;
     }
 
     /* Strict mode: check field count consistency */
     if (parser->config.strict_mode) {
         if (parser->expected_field_count == 0) {
             /* First row - set expected count */
-            parser->expected_field_count = row->field_count;
-        } else if (row->field_count != parser->expected_field_count) {
+            parser->expected_field_count = parser->field_total;
+        } else if (parser->field_total != parser->expected_field_count) {
             /* Field count mismatch */
-            csvkit_row_free(row);
+            parser->span_count = 0;
             set_error(parser, "Field count mismatch in strict mode");
             return CSVKIT_ERROR_PARSE;
         }
     }
 
+    return CSVKIT_OK;
+}
+
+/* Point parser->views at the fields of the current row */
+static bool fill_views(csvkit_parser_t *parser) {
+    if (parser->span_count > parser->view_capacity) {
+        size_t new_capacity = parser->view_capacity ? parser->view_capacity : INITIAL_FIELD_COUNT;
+        while (new_capacity < parser->span_count) {
+            new_capacity *= 2;
+        }
+        csvkit_field_view_t *new_views = realloc(parser->views, new_capacity * sizeof(csvkit_field_view_t));
+        if (!new_views) return false;
+        parser->views = new_views;
+        parser->view_capacity = new_capacity;
+    }
+
+    for (size_t i = 0; i < parser->span_count; i++) {
+        parser->views[i].data = csvkit_span_data(parser, &parser->spans[i]);
+        parser->views[i].len = parser->spans[i].len;
+    }
+    return true;
+}
+
+/* Names of the projected columns; columns past the end of the header row
+ * have empty names */
+static csvkit_header_t *project_header(const csvkit_parser_t *parser) {
+    csvkit_field_view_t *names = malloc(parser->projected_count * sizeof(csvkit_field_view_t));
+    if (!names) return NULL;
+
+    for (size_t i = 0; i < parser->projected_count; i++) {
+        size_t column = parser->projection[i];
+        names[i].data = column < parser->span_count ? parser->views[column].data : "";
+        names[i].len = column < parser->span_count ? parser->views[column].len : 0;
+    }
+
+    csvkit_header_t *header = csvkit_header_from_views(names, parser->projected_count);
+    free(names);
+    return header;
+}
+
+/* Consume the header row, hash its names and resolve projected column
+ * names against it */
+static csvkit_error_t read_header(csvkit_parser_t *parser) {
+    parser->header_pending = false;
+    parser->projecting = false;
+    csvkit_header_free(parser->header);
+    parser->header = NULL;
+
+    csvkit_error_t result = parse_next_row(parser);
+    if (result != CSVKIT_OK) {
+        /* A push source may not have received the whole header yet */
+        if (result == CSVKIT_ERROR_EOF && parser->source_type == SOURCE_PUSH && !parser->input_eof) {
+            parser->header_pending = true;
+        }
+        return result;
+    }
+
+    parser->header_row = parser->row_number;
+
+    csvkit_header_t *header = NULL;
+    if (fill_views(parser)) {
+        header = csvkit_header_from_views(parser->views, parser->span_count);
+    }
+    if (!header) {
+        csvkit_close(parser);
+        set_error(parser, "Out of memory");
+        return CSVKIT_ERROR_MEMORY;
+    }
+
+    if (parser->column_names) {
+        for (size_t i = 0; i < parser->projected_count; i++) {
+            const char *name = parser->column_names[i];
+            size_t column = csvkit_header_find(header, name, strlen(name));
+            if (column == NO_COLUMN) {
+                /* Rows without the requested columns would be meaningless */
+                csvkit_header_free(header);
+                csvkit_close(parser);
+                set_error(parser, "Projected column not found in header");
+                return CSVKIT_ERROR_INVALID_ARG;
+            }
+            parser->projection[i] = column;
+        }
+        if (!build_column_map(parser)) {
+            csvkit_header_free(header);
+            csvkit_close(parser);
+            set_error(parser, "Out of memory");
+            return CSVKIT_ERROR_MEMORY;
+        }
+    }
+
+    /* Lookups by name give the index of the returned field */
+    if (parser->projected_count > 0) {
+        csvkit_header_free(header);
+        header = project_header(parser);
+        if (!header) {
+            csvkit_close(parser);
+            set_error(parser, "Out of memory");
+            return CSVKIT_ERROR_MEMORY;
+        }
+    }
+
+    parser->header = header;
+    parser->projecting = parser->projected_count > 0;
+    return CSVKIT_OK;
+}
+
+const csvkit_header_t *csvkit_get_header(csvkit_parser_t *parser) {
+    if (!parser) return NULL;
+
+    if (parser->header_pending && parser->source_type != SOURCE_NONE) {
+        read_header(parser);
+    }
+    return parser->header;
+}
+
+/* Read the next data row, consuming the header first if there is one */
+static csvkit_error_t next_row(csvkit_parser_t *parser) {
+    if (parser->header_pending) {
+        csvkit_error_t result = read_header(parser);
+        if (result != CSVKIT_OK) return result;
+    }
+
+    /* Hand large in-memory inputs to worker threads on the first read */
+    if (parser->config.threads > 1 && !parser->parallel && !parser->parallel_tried) {
+        parser->parallel_tried = true;
+        csvkit_parallel_start(parser);
+    }
+
+    return parse_next_row(parser);
+}
+
+csvkit_error_t csvkit_read_row(csvkit_parser_t *parser, csvkit_row_t **out_row) {
+    if (!parser || !out_row) return CSVKIT_ERROR_INVALID_ARG;
+    if (parser->source_type == SOURCE_NONE) return CSVKIT_ERROR_INVALID_ARG;
+
+    *out_row = NULL;
+
+    csvkit_error_t result = next_row(parser);
+    if (result != CSVKIT_OK) {
+        return result;
+    }
+
+    /* Allocate row structure */
+    csvkit_row_t *row = calloc(1, sizeof(csvkit_row_t));
+    if (!row) {
+        set_error(parser, "Out of memory");
+        return CSVKIT_ERROR_MEMORY;
+    }
+
+    row->fields = malloc(parser->span_count * sizeof(char *));
+    if (!row->fields) {
+        free(row);
+        set_error(parser, "Out of memory");
+        return CSVKIT_ERROR_MEMORY;
+    }
+
+    for (size_t i = 0; i < parser->span_count; i++) {
+        const field_span_t *span = &parser->spans[i];
+        char *field_value = string_duplicate(csvkit_span_data(parser, span), span->len);
+        if (!field_value) {
+            csvkit_row_free(row);
+            set_error(parser, "Out of memory");
+            return CSVKIT_ERROR_MEMORY;
+        }
+        row->fields[row->field_count++] = field_value;
+    }
+
+    row->row_number = parser->row_number;
     *out_row = row;
     return CSVKIT_OK;
 }
 
-void csvkit_row_free(csvkit_row_t *row) {
+csvkit_error_t csvkit_read_row_view(csvkit_parser_t *parser, csvkit_row_view_t *view) {
+    if (!parser || !view) return CSVKIT_ERROR_INVALID_ARG;
+    if (parser->source_type == SOURCE_NONE) return CSVKIT_ERROR_INVALID_ARG;
+
+    view->fields = NULL;
+    view->field_count = 0;
+
+    csvkit_error_t result = next_row(parser);
+    if (result != CSVKIT_OK) {
+        return result;
+    }
+
+    if (!fill_views(parser)) {
+        set_error(parser, "Out of memory");
+        return CSVKIT_ERROR_MEMORY;
+    }
+
+    view->fields = parser->views;
+    view->field_count = parser->span_count;
+    view->row_number = parser->row_number;
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_parse_with_callbacks(csvkit_parser_t *parser, const csvkit_callbacks_t *callbacks) {
+    if (!parser || !callbacks) return CSVKIT_ERROR_INVALID_ARG;
+    if (parser->source_type == SOURCE_NONE) return CSVKIT_ERROR_INVALID_ARG;
+
+    csvkit_error_t result;
+    while ((result = next_row(parser)) == CSVKIT_OK) {
+        /* Spans point into the input window, or into the arena for
+         * unescaped fields; nothing is copied per row */
+        if (callbacks->on_field) {
+            for (size_t i = 0; i < parser->span_count; i++) {
+                const field_span_t *span = &parser->spans[i];
+                result = callbacks->on_field(csvkit_span_data(parser, span), span->len, i,
+                                             callbacks->user_data);
+                if (result != CSVKIT_OK) return result;
+            }
+        }
+        if (callbacks->on_row_end) {
+            result = callbacks->on_row_end(parser->row_number, callbacks->user_data);
+            if (result != CSVKIT_OK) return result;
+        }
+    }
+
+    return result == CSVKIT_ERROR_EOF ? CSVKIT_OK : result;
+}
+
+void csvkit_row_init(csvkit_row_t *row) {
     if (!row) return;
 
-    for (size_t i = 0; i < row->field_count; i++) {
-        free(row->fields[i]);
+    memset(row, 0, sizeof(*row));
+}
+
+csvkit_error_t csvkit_read_row_into(csvkit_parser_t *parser, csvkit_row_t *row) {
+    if (!parser || !row) return CSVKIT_ERROR_INVALID_ARG;
+    if (parser->source_type == SOURCE_NONE) return CSVKIT_ERROR_INVALID_ARG;
+
+    row->field_count = 0;
+
+    csvkit_error_t result = next_row(parser);
+    if (result != CSVKIT_OK) {
+        return result;
+    }
+
+    /* Grow the row's storage only when this row is larger than any before */
+    if (parser->span_count > row->fields_capacity) {
+        size_t new_capacity = row->fields_capacity ? row->fields_capacity : INITIAL_FIELD_COUNT;
+        while (new_capacity < parser->span_count) {
+            new_capacity *= 2;
+        }
+        char **new_fields = realloc(row->fields, new_capacity * sizeof(char *));
+        if (!new_fields) {
+            set_error(parser, "Out of memory");
+            return CSVKIT_ERROR_MEMORY;
+        }
+        row->fields = new_fields;
+        row->fields_capacity = new_capacity;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < parser->span_count; i++) {
+        total += parser->spans[i].len + 1;
+    }
+
+    if (total > row->data_capacity) {
+        size_t new_capacity = row->data_capacity ? row->data_capacity : INITIAL_BUFFER_SIZE;
+        while (new_capacity < total) {
+            new_capacity *= 2;
+        }
+        char *new_data = realloc(row->data, new_capacity);
+        if (!new_data) {
+            set_error(parser, "Out of memory");
+            return CSVKIT_ERROR_MEMORY;
+        }
+        row->data = new_data;
+        row->data_capacity = new_capacity;
+    }
+
+    char *dest = row->data;
+    for (size_t i = 0; i < parser->span_count; i++) {
+        const field_span_t *span = &parser->spans[i];
+        memcpy(dest, csvkit_span_data(parser, span), span->len);
+        dest[span->len] = '\0';
+        row->fields[i] = dest;
+        dest += span->len + 1;
+    }
+
+    row->field_count = parser->span_count;
+    row->row_number = parser->row_number;
+    return CSVKIT_OK;
+}
+
+void csvkit_row_release(csvkit_row_t *row) {
+    if (!row) return;
+
+    if (!row->data) {
+        for (size_t i = 0; i < row->field_count; i++) {
+            free(row->fields[i]);
+        }
     }
     free(row->fields);
+    free(row->data);
+    memset(row, 0, sizeof(*row));
+}
+
+void csvkit_row_free(csvkit_row_t *row) {
+    if (!row) return;
+
+    csvkit_row_release(row);
     free(row);
 }
 
+/*
+ * Row offset index
+ *
+ * Sidecar layout, every integer 64-bit little-endian: the magic bytes
+ * "CSVKRIX1", the interval, the row count, the source size and the quote
+ * and escape characters (low two bytes), followed by the source offset
+ * of rows 1, 1 + interval, 1 + 2 * interval, ...
+ */
+
+#define ROW_INDEX_HEADER_SIZE 40
+
+static const char row_index_magic[8] = {'C', 'S', 'V', 'K', 'R', 'I', 'X', '1'};
+
+static void put_u64(unsigned char *p, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static uint64_t get_u64(const unsigned char *p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static uint64_t row_index_dialect(const csvkit_parser_t *parser) {
+    return (uint64_t)(unsigned char)parser->config.quote_char |
+           (uint64_t)(unsigned char)parser->config.escape_char << 8;
+}
+
+/* Size of a seekable source; false for streams, compressed input and
+ * closed parsers */
+static bool source_size(csvkit_parser_t *parser, uint64_t *size) {
+    if (parser->decoder) return false;
+    if (parser->source_type == SOURCE_STRING) {
+        *size = parser->string_len;
+        return true;
+    }
+    if (parser->source_type == SOURCE_FILE) {
+        struct stat st;
+        if (fstat(parser->fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            *size = (uint64_t)st.st_size;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Restart parsing at a row boundary `offset` bytes into the source */
+static bool seek_source(csvkit_parser_t *parser, uint64_t offset) {
+    csvkit_parallel_stop(parser);
+    csvkit_readahead_stop(parser);
+
+    if (parser->source_type == SOURCE_STRING) {
+        if (offset > parser->string_len) return false;
+        reset_input(parser, parser->string_data, parser->string_len, true);
+        parser->input_pos = (size_t)offset;
+        parser->row_start = (size_t)offset;
+        return true;
+    }
+
+    /* Compressed input can only be decoded again from the start */
+    if (parser->decoder && offset != 0) return false;
+
+    off_t target = (off_t)offset;
+    if (target < 0 || (uint64_t)target != offset ||
+        lseek(parser->fd, target, SEEK_SET) < 0) {
+        return false;
+    }
+    if (parser->decoder) {
+        csvkit_decoder_reset(parser->decoder);
+    }
+    reset_input(parser, NULL, 0, false);
+    parser->input_offset = offset;
+    return true;
+}
+
+bool csvkit_rewind(csvkit_parser_t *parser) {
+    if (parser->source_type != SOURCE_STRING && parser->source_type != SOURCE_FILE) {
+        return false;
+    }
+    if (!seek_source(parser, 0)) return false;
+
+    reset_rows(parser);
+    return true;
+}
+
+static bool read_at(int fd, unsigned char *buf, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = pread(fd, buf, len, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf += n;
+        len -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return true;
+}
+
+csvkit_error_t csvkit_build_row_index(csvkit_parser_t *parser, const char *index_path,
+                                      size_t interval) {
+    if (!parser || !index_path || interval == 0) return CSVKIT_ERROR_INVALID_ARG;
+
+    uint64_t size;
+    if (!source_size(parser, &size)) {
+        set_error(parser, "Row index requires an uncompressed file or string source");
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+    if (!seek_source(parser, 0)) {
+        set_error(parser, strerror(errno));
+        return CSVKIT_ERROR_IO;
+    }
+
+    FILE *out = fopen(index_path, "wb");
+    if (!out) {
+        set_error(parser, strerror(errno));
+        return CSVKIT_ERROR_IO;
+    }
+
+    /* The header is written last, once the row count is known */
+    unsigned char header[ROW_INDEX_HEADER_SIZE] = {0};
+    unsigned char entry[8];
+    uint64_t rows = 0;
+    csvkit_error_t result = CSVKIT_OK;
+
+    if (fwrite(header, 1, sizeof(header), out) != sizeof(header)) {
+        set_error(parser, strerror(errno));
+        result = CSVKIT_ERROR_IO;
+    }
+
+    while (result == CSVKIT_OK) {
+        result = csvkit_parse_raw_row(parser);
+        if (result == CSVKIT_ERROR_EOF) break;
+        if (result != CSVKIT_OK) {
+            report_row_error(parser, result);
+            break;
+        }
+
+        if (rows % interval == 0) {
+            put_u64(entry, parser->input_offset + parser->row_start);
+            if (fwrite(entry, 1, sizeof(entry), out) != sizeof(entry)) {
+                set_error(parser, strerror(errno));
+                result = CSVKIT_ERROR_IO;
+            }
+        }
+        rows++;
+    }
+
+    if (result == CSVKIT_ERROR_EOF) {
+        memcpy(header, row_index_magic, sizeof(row_index_magic));
+        put_u64(header + 8, interval);
+        put_u64(header + 16, rows);
+        put_u64(header + 24, size);
+        put_u64(header + 32, row_index_dialect(parser));
+
+        result = CSVKIT_OK;
+        if (fseek(out, 0, SEEK_SET) != 0 ||
+            fwrite(header, 1, sizeof(header), out) != sizeof(header)) {
+            set_error(parser, strerror(errno));
+            result = CSVKIT_ERROR_IO;
+        }
+    }
+
+    if (fclose(out) != 0 && result == CSVKIT_OK) {
+        set_error(parser, strerror(errno));
+        result = CSVKIT_ERROR_IO;
+    }
+
+    /* Never leave a partial index behind */
+    if (result != CSVKIT_OK) {
+        remove(index_path);
+        return result;
+    }
+
+    /* Leave the parser at the first row again */
+    if (!csvkit_rewind(parser)) {
+        set_error(parser, strerror(errno));
+        return CSVKIT_ERROR_IO;
+    }
+
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_seek_row(csvkit_parser_t *parser, const char *index_path,
+                               size_t row_number) {
+    if (!parser || !index_path || row_number == 0) return CSVKIT_ERROR_INVALID_ARG;
+
+    uint64_t size;
+    if (!source_size(parser, &size)) {
+        set_error(parser, "Row index requires an uncompressed file or string source");
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+
+    /* Header names must be resolved before jumping past the header */
+    if (parser->header_pending) {
+        csvkit_error_t result = read_header(parser);
+        if (result != CSVKIT_OK && result != CSVKIT_ERROR_EOF) return result;
+    }
+
+    /* The index counts the header like any row; it is never returned */
+    if (row_number <= parser->header_row) {
+        row_number = parser->header_row + 1;
+    }
+
+    int fd = open_readonly(parser, index_path);
+    if (fd < 0) return CSVKIT_ERROR_IO;
+
+    unsigned char header[ROW_INDEX_HEADER_SIZE];
+    unsigned char entry[8];
+    if (!read_at(fd, header, sizeof(header), 0)) {
+        close(fd);
+        set_error(parser, "Invalid row index");
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+
+    uint64_t interval = get_u64(header + 8);
+    uint64_t rows = get_u64(header + 16);
+    if (memcmp(header, row_index_magic, sizeof(row_index_magic)) != 0 || interval == 0 ||
+        get_u64(header + 24) != size || get_u64(header + 32) != row_index_dialect(parser)) {
+        close(fd);
+        set_error(parser, "Row index does not match the source");
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+
+    if (row_number > rows) {
+        close(fd);
+        return CSVKIT_ERROR_EOF;
+    }
+
+    uint64_t entry_pos = ROW_INDEX_HEADER_SIZE + (row_number - 1) / interval * 8;
+    bool ok = read_at(fd, entry, sizeof(entry), entry_pos);
+    close(fd);
+    if (!ok) {
+        set_error(parser, "Invalid row index");
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+
+    if (!seek_source(parser, get_u64(entry))) {
+        set_error(parser, strerror(errno));
+        return CSVKIT_ERROR_IO;
+    }
+
+    /* Walk from the indexed row to the requested one */
+    for (uint64_t skip = (row_number - 1) % interval; skip > 0; skip--) {
+        csvkit_error_t result = csvkit_parse_raw_row(parser);
+        if (result != CSVKIT_OK) {
+            report_row_error(parser, result);
+            return result;
+        }
+    }
+
+    parser->row_number = row_number - 1;
+    parser->expected_field_count = 0;
+
+    return CSVKIT_OK;
+}
+
 const char *csvkit_get_error_msg(csvkit_parser_t *parser) {
     return parser ? parser->error_msg : NULL;
 }
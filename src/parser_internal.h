@@ -0,0 +1,242 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/* Internal parser state shared between source files - not part of the public API */
+
+#ifndef CSVKIT_PARSER_INTERNAL_H
+#define CSVKIT_PARSER_INTERNAL_H
+
+#include "csvkit.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_BUFFER_SIZE 1024
+#define INITIAL_FIELD_COUNT 16
+#define DEFAULT_INPUT_BUFFER_SIZE (256 * 1024)
+
+typedef enum {
+    SOURCE_NONE,
+    SOURCE_FILE,
+    SOURCE_STREAM,
+    SOURCE_STRING,
+    SOURCE_PUSH
+} source_type_t;
+
+/* A parsed field: a slice of the current row's input bytes, or of the
+ * arena when the field had to be unescaped */
+typedef struct {
+    size_t offset;
+    size_t len;
+    bool copied;
+} field_span_t;
+
+typedef struct csvkit_parallel csvkit_parallel_t;
+typedef struct csvkit_readahead csvkit_readahead_t;
+typedef struct csvkit_decoder csvkit_decoder_t;
+
+/* column_map entry for a column that is not projected */
+#define NO_COLUMN CSVKIT_NO_COLUMN
+
+struct csvkit_parser {
+    csvkit_config_t config;
+    source_type_t source_type;
+    FILE *file;
+    int fd;                       /* Descriptor for SOURCE_FILE */
+    const char *string_data;
+    size_t string_len;
+    size_t row_number;
+    char *error_msg;
+    bool owns_file;
+    size_t expected_field_count;  /* For strict mode */
+    bool header_pending;          /* config.has_header and the header is unread */
+    size_t header_row;            /* Row number of the header once read, or 0 */
+
+    /* Column projection. The config's column arrays are copied here;
+     * header names are resolved into `projection` once the header is read. */
+    size_t *projection;           /* Projected column indexes, in output order */
+    size_t projected_count;       /* 0 = every column */
+    char **column_names;          /* Copy of config.column_names */
+    size_t *column_map;           /* Output slot of each column, or NO_COLUMN */
+    size_t column_map_len;
+    bool projecting;              /* Projection is resolved and applies to rows */
+    csvkit_header_t *header;      /* Names of the returned columns (config.has_header) */
+
+    /* Copy of config.schema, and converted values of the last typed row */
+    csvkit_type_t *schema;
+    csvkit_value_t *values;
+    size_t value_capacity;
+
+    /* Input window: points into input_buf for file/stream sources,
+     * or directly at string_data for string sources */
+    const char *input;
+    uint64_t input_offset;        /* Source offset of input[0] */
+    size_t input_pos;
+    size_t input_len;
+    bool input_eof;
+    int input_errno;              /* Saved errno of a failed read */
+    char *input_buf;
+    size_t input_capacity;
+
+    /* SOURCE_PUSH: fed bytes are appended to input_buf, and input_eof is
+     * set by csvkit_feed_end(). Once a row has been cut short, the scan for
+     * its end resumes at push_scan_pos with the saved quote state. */
+    csvkit_row_callback_t push_callback;
+    void *push_user_data;
+    bool push_starved;            /* The last parse ran out of fed bytes */
+    bool push_scanning;           /* A scan for the next row end is under way */
+    size_t push_scan_pos;
+    bool push_in_quotes;
+    bool push_field_started;
+
+    /* Decompression of file and stream sources (config.decompress). Pipes
+     * and streams are checked for magic bytes by their first read. */
+    csvkit_decoder_t *decoder;
+    bool sniff_pending;
+
+    /* Buffers read ahead of the parser (config.read_ahead) */
+    csvkit_readahead_t *readahead;
+    bool readahead_tried;         /* Read-ahead was considered since the last seek */
+
+    /* Read-only file mapping backing a SOURCE_STRING source */
+    void *map_addr;
+    size_t map_len;
+
+    /* Per-row parse state, reused across rows. The bytes of the current
+     * row stay in the input window from row_start until the next read. */
+    size_t row_start;
+    field_span_t *spans;
+    size_t span_count;
+    size_t span_capacity;
+    char *arena;                  /* Unescaped copies of quoted fields */
+    size_t arena_len;
+    size_t arena_capacity;
+    csvkit_field_view_t *views;
+    size_t view_capacity;
+    size_t field_total;           /* Fields seen in the row, projected or not */
+    bool skip_field;              /* The field being parsed is not projected */
+    bool skipped_data;            /* A field that was not projected is non-empty */
+
+    /* Structural index (config.structural_index): offsets, relative to
+     * index_base, of unquoted delimiters and line endings in the window
+     * input[index_base, index_end) */
+    uint32_t *index;
+    size_t index_count;
+    size_t index_pos;
+    size_t index_base;
+    size_t index_end;
+    size_t index_cooldown;        /* Rows to parse without the index */
+
+    /* Worker threads (config.threads), while parsing in parallel */
+    csvkit_parallel_t *parallel;
+    bool parallel_tried;          /* Parallel parsing was considered for this input */
+};
+
+/* Replace the parser's error message (msg may be NULL) */
+static inline void csvkit_set_error(csvkit_parser_t *parser, const char *msg) {
+    free(parser->error_msg);
+    parser->error_msg = NULL;
+    if (msg) {
+        size_t len = strlen(msg) + 1;
+        parser->error_msg = malloc(len);
+        if (parser->error_msg) {
+            memcpy(parser->error_msg, msg, len);
+        }
+    }
+}
+
+/* Bytes of a span parsed by the last row read */
+static inline const char *csvkit_span_data(const csvkit_parser_t *parser, const field_span_t *span) {
+    return span->copied ? parser->arena + span->offset :
+                          parser->input + parser->row_start + span->offset;
+}
+
+/* Type of an output column under config.schema */
+static inline csvkit_type_t csvkit_column_type(const csvkit_parser_t *parser, size_t column) {
+    return column < parser->config.schema_count ? parser->schema[column] : CSVKIT_TYPE_STRING;
+}
+
+/* Convert one field to `type` (convert.c). Empty fields of typed columns
+ * are null. */
+csvkit_error_t csvkit_convert_field(csvkit_type_t type, const char *data, size_t len,
+                                    csvkit_value_t *value);
+
+/* Set the error message for a failed csvkit_convert_field() on `column`
+ * of the current row */
+void csvkit_report_conversion_error(csvkit_parser_t *parser, csvkit_error_t result, size_t column);
+
+/* Build a header from column names (header.c) */
+csvkit_header_t *csvkit_header_from_views(const csvkit_field_view_t *names, size_t count);
+
+/* Parse one row into parser->spans, without row numbering, empty-row
+ * skipping or strict-mode checks */
+csvkit_error_t csvkit_parse_raw_row(csvkit_parser_t *parser);
+
+/* Whether the input window of a push source holds the whole next row,
+ * scanning from where the last call stopped (push.c). Always true once
+ * the input has ended. */
+bool csvkit_push_row_ready(csvkit_parser_t *parser);
+
+/* Restart a file or string source at its first row, header included.
+ * Returns false for streams and unseekable files. */
+bool csvkit_rewind(csvkit_parser_t *parser);
+
+/* C libraries whose FILE layout csvkit_stream_buffered() knows. uClibc
+ * also defines __GLIBC__, but lays FILE out differently. */
+#if defined(__GLIBC__) && !defined(__UCLIBC__)
+#define CSVKIT_GLIBC_FILE
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+      defined(__OpenBSD__) || defined(__DragonFly__)
+#define CSVKIT_BSD_FILE
+#endif
+
+#if defined(CSVKIT_HAVE_FREADAHEAD) || defined(CSVKIT_GLIBC_FILE) || defined(CSVKIT_BSD_FILE)
+#define CSVKIT_HAVE_STREAM_BUFFERED
+#endif
+
+/* Bytes a stream holds in its stdio buffer, which fread() returns without
+ * waiting for the descriptor; SIZE_MAX where the C library does not tell */
+size_t csvkit_stream_buffered(FILE *file);
+
+/* Read up to len bytes of a source into dest. Returns 0 at the end of
+ * the source or on error, setting *error to an errno value. */
+typedef size_t (*csvkit_source_read_t)(void *context, char *dest, size_t len, int *error);
+
+/* Decompression (decompress.c). csvkit_detect_compression() needs the
+ * first 4 bytes of the source; csvkit_magic_prefix() tells whether fewer
+ * bytes may still be the start of a compressed source. csvkit_decoder_read()
+ * pulls compressed bytes through read_source and returns 0 at the end of
+ * the data or on error; csvkit_decoder_error() then explains a decoding
+ * failure. */
+csvkit_compression_t csvkit_detect_compression(const unsigned char *bytes, size_t len);
+bool csvkit_magic_prefix(const unsigned char *bytes, size_t len);
+csvkit_decoder_t *csvkit_decoder_new(csvkit_compression_t format, const char *initial, size_t initial_len);
+void csvkit_decoder_reset(csvkit_decoder_t *decoder);
+void csvkit_decoder_free(csvkit_decoder_t *decoder);
+const char *csvkit_decoder_error(const csvkit_decoder_t *decoder);
+size_t csvkit_decoder_read(csvkit_decoder_t *decoder, char *dest, size_t len,
+                           csvkit_source_read_t read_source, void *context, int *error);
+
+/* Read-ahead (readahead.c). csvkit_readahead_fill() takes the place of
+ * a read in fill_input(); csvkit_readahead_stop() must be called before
+ * the descriptor or stream is used directly again. Regular files are
+ * read at offsets, so their descriptor is not moved past the parser. */
+bool csvkit_readahead_start(csvkit_parser_t *parser);
+bool csvkit_readahead_fill(csvkit_parser_t *parser);
+void csvkit_readahead_stop(csvkit_parser_t *parser);
+
+/* Parallel parsing (parallel.c). csvkit_parallel_start() returns false
+ * when the input is too small to split or threads cannot be started, in
+ * which case parsing continues on the calling thread. */
+bool csvkit_parallel_start(csvkit_parser_t *parser);
+csvkit_error_t csvkit_parallel_next_row(csvkit_parser_t *parser);
+void csvkit_parallel_stop(csvkit_parser_t *parser);
+
+#endif /* CSVKIT_PARSER_INTERNAL_H */
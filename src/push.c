@@ -0,0 +1,174 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/* Push sources: bytes arrive in arbitrary chunks through csvkit_feed().
+ * A row cut off at the end of a chunk is finished by a resumable scan that
+ * keeps its quote state between chunks, so a row split into many chunks
+ * is scanned once rather than reparsed from its start for every chunk. */
+
+#include "parser_internal.h"
+#include "scan.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool csvkit_push_row_ready(csvkit_parser_t *parser) {
+    if (parser->input_eof) return true;
+
+    if (!parser->push_scanning) {
+        parser->push_scanning = true;
+        parser->push_scan_pos = parser->input_pos;
+        parser->push_in_quotes = false;
+        parser->push_field_started = false;
+    }
+
+    const char *input = parser->input;
+    size_t len = parser->input_len;
+    size_t pos = parser->push_scan_pos;
+    bool in_quotes = parser->push_in_quotes;
+    bool field_started = parser->push_field_started;
+    char delimiter = parser->config.delimiter;
+    char quote = parser->config.quote_char;
+    char escape = parser->config.escape_char;
+    bool ready = false;
+
+    /* Mirrors the record boundaries of parse_row_internal() */
+    while (pos < len) {
+        if (in_quotes) {
+            pos += csvkit_scan_run(input + pos, len - pos, quote, escape, escape);
+            if (pos >= len) break;
+
+            if (input[pos] == escape) {
+                /* The byte after an escape decides what it means */
+                if (pos + 1 >= len) break;
+                char next = input[pos + 1];
+                if (next == quote || next == escape || escape != quote) {
+                    pos += 2;
+                } else {
+                    in_quotes = false;
+                    pos++;
+                }
+            } else {
+                in_quotes = false;
+                pos++;
+            }
+            continue;
+        }
+
+        if (field_started) {
+            pos += csvkit_scan_run(input + pos, len - pos, delimiter, '\r', '\n');
+            if (pos >= len) break;
+        }
+
+        char c = input[pos];
+        if (c == '\r' || c == '\n') {
+            /* A CR may be the first half of a CRLF still to come */
+            if (c == '\r' && pos + 1 >= len) break;
+            ready = true;
+            break;
+        }
+        if (c == quote && !field_started) {
+            in_quotes = true;
+            field_started = true;
+        } else {
+            field_started = c != delimiter;
+        }
+        pos++;
+    }
+
+    if (ready) {
+        /* The next scan starts with the row after this one */
+        parser->push_scanning = false;
+        return true;
+    }
+    parser->push_scan_pos = pos;
+    parser->push_in_quotes = in_quotes;
+    parser->push_field_started = field_started;
+    return false;
+}
+
+/* Append bytes to the input window, first dropping the rows already
+ * parsed if that makes room */
+static bool append_input(csvkit_parser_t *parser, const char *data, size_t len) {
+    size_t consumed = parser->input_pos;
+    size_t keep = parser->input_len - consumed;
+
+    if (consumed > 0 && (consumed == parser->input_len || parser->input_len + len > parser->input_capacity)) {
+        if (keep > 0) {
+            memmove(parser->input_buf, parser->input_buf + consumed, keep);
+        }
+        parser->input_offset += consumed;
+        parser->input_pos = 0;
+        parser->input_len = keep;
+        parser->row_start = 0;
+        if (parser->push_scanning) {
+            parser->push_scan_pos -= consumed;
+        }
+    }
+
+    size_t needed = parser->input_len + len;
+    if (needed > parser->input_capacity) {
+        size_t capacity = parser->input_capacity ? parser->input_capacity :
+            (parser->config.buffer_size ? parser->config.buffer_size : DEFAULT_INPUT_BUFFER_SIZE);
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        char *new_buf = realloc(parser->input_buf, capacity);
+        if (!new_buf) return false;
+        parser->input_buf = new_buf;
+        parser->input_capacity = capacity;
+    }
+
+    if (len > 0) {
+        memcpy(parser->input_buf + parser->input_len, data, len);
+    }
+    parser->input = parser->input_buf;
+    parser->input_len += len;
+    return true;
+}
+
+/* Hand every complete row to the callback */
+static csvkit_error_t deliver_rows(csvkit_parser_t *parser) {
+    if (!parser->push_callback) return CSVKIT_OK;
+
+    csvkit_row_view_t view;
+    csvkit_error_t result;
+    while ((result = csvkit_read_row_view(parser, &view)) == CSVKIT_OK) {
+        result = parser->push_callback(&view, parser->push_user_data);
+        if (result != CSVKIT_OK) return result;
+    }
+    return result == CSVKIT_ERROR_EOF ? CSVKIT_OK : result;
+}
+
+csvkit_error_t csvkit_feed(csvkit_parser_t *parser, const char *data, size_t len) {
+    if (!parser || (!data && len > 0)) return CSVKIT_ERROR_INVALID_ARG;
+
+    if (parser->source_type != SOURCE_PUSH || parser->input_eof) {
+        csvkit_set_error(parser, "Parser is not open for feeding");
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+
+    if (!append_input(parser, data, len)) {
+        csvkit_set_error(parser, "Out of memory");
+        return CSVKIT_ERROR_MEMORY;
+    }
+    return deliver_rows(parser);
+}
+
+csvkit_error_t csvkit_feed_end(csvkit_parser_t *parser) {
+    if (!parser) return CSVKIT_ERROR_INVALID_ARG;
+
+    if (parser->source_type != SOURCE_PUSH || parser->input_eof) {
+        csvkit_set_error(parser, "Parser is not open for feeding");
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+
+    parser->input_eof = true;
+    return deliver_rows(parser);
+}
@@ -0,0 +1,567 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Read-ahead for file and stream sources (config.read_ahead).
+ *
+ * A ring of buffers is filled in order while the parser works on the
+ * buffer before them. Each buffer has free space in front of its data:
+ * when the parser moves on, the unfinished row at the end of its window
+ * is copied there, so parsing continues in the new buffer without moving
+ * the data just read. Rows longer than that space continue in input_buf
+ * instead. Buffers are refilled in the order they were filled.
+ *
+ * Regular files are read at explicit offsets. Where io_uring is available
+ * every free buffer has a read in flight, so a fast device sees a deep
+ * queue without any extra thread; completions may arrive in any order,
+ * but buffers are still handed out in file order. Otherwise, and for
+ * pipes, streams and compressed input, an I/O thread reads one buffer at
+ * a time, with pread() for regular files. Compressed input is
+ * decompressed on that thread. Streams are read through stdio only for
+ * the bytes it already holds and then through their descriptor, which
+ * can be polled like any other.
+ */
+
+#define _GNU_SOURCE
+
+#include "parser_internal.h"
+#include "uring.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define MIN_READ_AHEAD_BUFFERS 2
+#define MAX_READ_AHEAD_BUFFERS 64
+
+/* Alignment of buffers, offsets and sizes for O_DIRECT reads. Logical
+ * block sizes above this are rare enough to leave to the fallback. */
+#define DIRECT_IO_ALIGN 4096
+
+/* Largest single io_uring read (its length field is 32 bits) */
+#define MAX_URING_READ ((size_t)1 << 30)
+
+struct csvkit_readahead {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t filled;        /* A buffer was filled, or reading ended */
+    pthread_cond_t released;      /* The parser gave a buffer back, or stop was set */
+
+    char **buffers;               /* headroom + chunk bytes each */
+    size_t *lengths;              /* Bytes read into each buffer */
+    size_t buffer_count;
+    size_t chunk;                 /* Bytes read at a time */
+    size_t headroom;              /* Space in front of the data for a carried-over row */
+
+    /* The ring in fill order: held buffers, then filled ones, then free ones */
+    size_t head;                  /* Next filled buffer to hand out */
+    size_t filled_count;          /* Filled buffers not handed out yet */
+    size_t held_count;            /* Handed out and not released yet */
+    bool window_held;             /* The parser's window is the oldest held buffer */
+
+    int fd;                       /* The source's descriptor, or -1 */
+    FILE *stream;                 /* SOURCE_STREAM stream, or NULL */
+    csvkit_decoder_t *decoder;    /* Decompresses what is read, or NULL */
+    bool poll_fd;                 /* Reads may block indefinitely (pipes, sockets) */
+    int wake[2];                  /* Written to interrupt poll() when stopping */
+
+    /* Regular files: reads at next_offset, from an O_DIRECT descriptor of
+     * our own with config.direct_io. The first buffer starts skip bytes
+     * before the parser's position when that had to be aligned. */
+    bool positional;
+    bool direct;                  /* fd is ours and has O_DIRECT */
+    uint64_t next_offset;
+    size_t skip;
+
+    /* io_uring: in fill order, the queued buffers are those counted by
+     * filled_count, whether their reads have completed or not */
+    csvkit_uring_t *uring;
+    uint64_t *offsets;            /* File offset of each buffer */
+    int *errors;                  /* errno of each buffer's failed read */
+    bool *done;                   /* Each buffer's read has completed */
+    size_t in_flight;             /* Reads the kernel has not completed */
+
+    bool stop;
+    bool finished;                /* End of input or a failed read; with io_uring,
+                                   * no more reads are queued */
+    int error;                    /* errno of the failed read */
+};
+
+/* One sequential read from the source (a csvkit_source_read_t). Returns
+ * 0 at end of input, on error (setting *error) or when woken up to stop. */
+static size_t read_source(void *context, char *dest, size_t len, int *error) {
+    csvkit_readahead_t *ra = context;
+
+    if (ra->stream) {
+        /* Streams without a descriptor (fmemopen() and the like) never wait */
+        size_t buffered = csvkit_stream_buffered(ra->stream);
+        if (buffered == 0 && ra->fd < 0) {
+            buffered = len;
+        }
+        if (buffered > 0) {
+            size_t got = fread(dest, 1, len < buffered ? len : buffered, ra->stream);
+            if (got == 0 && ferror(ra->stream)) {
+                *error = EIO;
+            }
+            return got;
+        }
+    }
+
+    for (;;) {
+        if (ra->poll_fd) {
+            struct pollfd fds[2] = {{ra->fd, POLLIN, 0}, {ra->wake[0], POLLIN, 0}};
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                *error = errno;
+                return 0;
+            }
+            if (fds[1].revents != 0) return 0;
+        }
+
+        ssize_t n = read(ra->fd, dest, len);
+        if (n >= 0) return (size_t)n;
+        if (errno != EINTR) {
+            *error = errno;
+            return 0;
+        }
+    }
+}
+
+/* Read one buffer's worth into dest, or less */
+static size_t read_chunk(csvkit_readahead_t *ra, char *dest, int *error) {
+    if (ra->positional) {
+        ssize_t n;
+        do {
+            n = pread(ra->fd, dest, ra->chunk, (off_t)ra->next_offset);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0) {
+            *error = errno;
+            return 0;
+        }
+        ra->next_offset += (uint64_t)n;
+        return (size_t)n;
+    }
+    if (ra->decoder) {
+        return csvkit_decoder_read(ra->decoder, dest, ra->chunk, read_source, ra, error);
+    }
+    return read_source(ra, dest, ra->chunk, error);
+}
+
+static void *reader_main(void *arg) {
+    csvkit_readahead_t *ra = arg;
+
+    pthread_mutex_lock(&ra->lock);
+    while (!ra->stop) {
+        if (ra->filled_count + ra->held_count >= ra->buffer_count) {
+            pthread_cond_wait(&ra->released, &ra->lock);
+            continue;
+        }
+        size_t slot = (ra->head + ra->filled_count) % ra->buffer_count;
+        pthread_mutex_unlock(&ra->lock);
+
+        int error = 0;
+        size_t got = read_chunk(ra, ra->buffers[slot] + ra->headroom, &error);
+
+        pthread_mutex_lock(&ra->lock);
+        if (got == 0) {
+            ra->finished = true;
+            ra->error = error;
+            pthread_cond_signal(&ra->filled);
+            break;
+        }
+        ra->lengths[slot] = got;
+        ra->filled_count++;
+        pthread_cond_signal(&ra->filled);
+
+        /* O_DIRECT reads end short of a block only at the end of the file */
+        if (ra->direct && got % DIRECT_IO_ALIGN != 0) {
+            ra->finished = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ra->lock);
+    return NULL;
+}
+
+/* Queue a read for the rest of a buffer */
+static bool queue_read(csvkit_readahead_t *ra, size_t slot) {
+    size_t len = ra->chunk - ra->lengths[slot];
+    if (len > MAX_URING_READ) len = MAX_URING_READ;
+    if (!csvkit_uring_read(ra->uring, ra->fd, ra->buffers[slot] + ra->headroom + ra->lengths[slot],
+                           len, ra->offsets[slot] + ra->lengths[slot], slot)) {
+        return false;
+    }
+    ra->in_flight++;
+    return true;
+}
+
+/* Queue reads into every free buffer, in ring order */
+static void queue_free_buffers(csvkit_readahead_t *ra) {
+    while (!ra->finished && ra->filled_count + ra->held_count < ra->buffer_count) {
+        size_t slot = (ra->head + ra->filled_count) % ra->buffer_count;
+        ra->offsets[slot] = ra->next_offset;
+        ra->lengths[slot] = 0;
+        ra->errors[slot] = 0;
+        ra->done[slot] = false;
+        if (!queue_read(ra, slot)) break;
+        ra->next_offset += ra->chunk;
+        ra->filled_count++;
+    }
+    if (!csvkit_uring_submit(ra->uring)) {
+        ra->finished = true;
+    }
+}
+
+/* Wait for one io_uring completion. Short reads are continued, so a
+ * buffer is done once it is full or the file has ended. */
+static bool complete_read(csvkit_readahead_t *ra) {
+    uint64_t tag;
+    int result;
+    if (!csvkit_uring_wait(ra->uring, &tag, &result)) return false;
+    ra->in_flight--;
+
+    size_t slot = (size_t)tag;
+    if (result == -EINTR || result == -EAGAIN) {
+        return queue_read(ra, slot) && csvkit_uring_submit(ra->uring);
+    }
+    if (result < 0) {
+        ra->errors[slot] = -result;
+        ra->lengths[slot] = 0;
+        ra->finished = true;
+    } else if (result == 0) {
+        ra->finished = true;
+    } else {
+        ra->lengths[slot] += (size_t)result;
+        if (ra->direct && result % DIRECT_IO_ALIGN != 0) {
+            ra->finished = true;
+        } else if (ra->lengths[slot] < ra->chunk) {
+            return queue_read(ra, slot) && csvkit_uring_submit(ra->uring);
+        }
+    }
+    ra->done[slot] = true;
+    return true;
+}
+
+/* Take the next buffer in file order, waiting for it to be read.
+ * Returns false at the end of input, with ra->error set after a failure. */
+static bool take_buffer(csvkit_readahead_t *ra, size_t *slot) {
+    pthread_mutex_lock(&ra->lock);
+    if (ra->uring) {
+        while (ra->filled_count > 0 && !ra->done[ra->head]) {
+            if (!complete_read(ra)) {
+                ra->error = EIO;
+                break;
+            }
+        }
+        if (ra->filled_count > 0 && ra->done[ra->head] && ra->lengths[ra->head] == 0) {
+            ra->error = ra->errors[ra->head];
+            ra->filled_count = 0;
+        }
+    } else {
+        while (ra->filled_count == 0 && !ra->finished) {
+            pthread_cond_wait(&ra->filled, &ra->lock);
+        }
+    }
+    if (ra->filled_count == 0 || (ra->uring && !ra->done[ra->head])) {
+        pthread_mutex_unlock(&ra->lock);
+        return false;
+    }
+
+    *slot = ra->head;
+    ra->head = (ra->head + 1) % ra->buffer_count;
+    ra->filled_count--;
+    ra->held_count++;
+    pthread_mutex_unlock(&ra->lock);
+    return true;
+}
+
+/* Give buffers back for reading: the previous window once the parser
+ * has moved into a new buffer (take_window), and the new buffer unless
+ * the window is in it (window_in_slot) */
+static void give_back(csvkit_readahead_t *ra, bool take_window, bool window_in_slot) {
+    pthread_mutex_lock(&ra->lock);
+    if (take_window) {
+        if (ra->window_held) {
+            ra->held_count--;
+        }
+        ra->window_held = window_in_slot;
+    }
+    if (!take_window || !window_in_slot) {
+        ra->held_count--;
+    }
+    if (ra->uring) {
+        queue_free_buffers(ra);
+    } else {
+        pthread_cond_signal(&ra->released);
+    }
+    pthread_mutex_unlock(&ra->lock);
+}
+
+static void free_readahead(csvkit_readahead_t *ra) {
+    if (ra->buffers) {
+        for (size_t i = 0; i < ra->buffer_count; i++) {
+            free(ra->buffers[i]);
+        }
+    }
+    free(ra->buffers);
+    free(ra->lengths);
+    free(ra->offsets);
+    free(ra->errors);
+    free(ra->done);
+    csvkit_uring_close(ra->uring);
+    if (ra->direct) {
+        close(ra->fd);
+    }
+    if (ra->poll_fd) {
+        close(ra->wake[0]);
+        close(ra->wake[1]);
+    }
+    free(ra);
+}
+
+static size_t round_up(size_t n, size_t align) {
+    return (n + align - 1) / align * align;
+}
+
+/* A second descriptor for the same file that bypasses the page cache,
+ * or -1 where the system or the filesystem does not support that */
+static int open_direct(int fd) {
+#ifdef O_DIRECT
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+    int direct;
+    do {
+        direct = open(path, O_RDONLY | O_DIRECT);
+    } while (direct < 0 && errno == EINTR);
+    return direct;
+#else
+    (void)fd;
+    return -1;
+#endif
+}
+
+bool csvkit_readahead_start(csvkit_parser_t *parser) {
+    if (parser->source_type != SOURCE_FILE && parser->source_type != SOURCE_STREAM) return false;
+
+    csvkit_readahead_t *ra = calloc(1, sizeof(csvkit_readahead_t));
+    if (!ra) return false;
+
+    ra->buffer_count = parser->config.read_ahead;
+    if (ra->buffer_count < MIN_READ_AHEAD_BUFFERS) ra->buffer_count = MIN_READ_AHEAD_BUFFERS;
+    if (ra->buffer_count > MAX_READ_AHEAD_BUFFERS) ra->buffer_count = MAX_READ_AHEAD_BUFFERS;
+    ra->chunk = parser->config.buffer_size ? parser->config.buffer_size : DEFAULT_INPUT_BUFFER_SIZE;
+    ra->headroom = ra->chunk / 4;
+    ra->fd = parser->source_type == SOURCE_FILE ? parser->fd : fileno(parser->file);
+    ra->stream = parser->source_type == SOURCE_STREAM ? parser->file : NULL;
+    ra->decoder = parser->decoder;
+
+    /* Regular files always make progress and are read at offsets, unless
+     * stdio has read ahead of the descriptor's position; anything else is
+     * polled so that stopping does not wait for input that may never come */
+    struct stat st;
+    if (ra->fd >= 0 && fstat(ra->fd, &st) == 0) {
+        off_t pos = S_ISREG(st.st_mode) && !ra->decoder && !ra->stream ?
+                    lseek(ra->fd, 0, SEEK_CUR) : -1;
+        if (pos >= 0) {
+            ra->positional = true;
+            ra->next_offset = (uint64_t)pos;
+            int direct = parser->config.direct_io ? open_direct(ra->fd) : -1;
+            if (direct >= 0) {
+                ra->fd = direct;
+                ra->direct = true;
+                ra->chunk = round_up(ra->chunk, DIRECT_IO_ALIGN);
+                ra->headroom = round_up(ra->headroom, DIRECT_IO_ALIGN);
+                ra->skip = (size_t)(ra->next_offset % DIRECT_IO_ALIGN);
+                ra->next_offset -= ra->skip;
+            }
+        } else if (!S_ISREG(st.st_mode)) {
+#ifndef CSVKIT_HAVE_STREAM_BUFFERED
+            /* A stream whose buffer cannot be seen could only be read
+             * with fread(), which neither returns short nor can be woken */
+            if (ra->stream) {
+                free_readahead(ra);
+                return false;
+            }
+#endif
+            if (pipe(ra->wake) != 0) {
+                free_readahead(ra);
+                return false;
+            }
+            ra->poll_fd = true;
+        }
+    }
+
+    ra->buffers = calloc(ra->buffer_count, sizeof(char *));
+    ra->lengths = calloc(ra->buffer_count, sizeof(size_t));
+    if (!ra->buffers || !ra->lengths) {
+        free_readahead(ra);
+        return false;
+    }
+    for (size_t i = 0; i < ra->buffer_count; i++) {
+        if (ra->direct) {
+            void *buffer;
+            ra->buffers[i] = posix_memalign(&buffer, DIRECT_IO_ALIGN, ra->headroom + ra->chunk) == 0 ?
+                             buffer : NULL;
+        } else {
+            ra->buffers[i] = malloc(ra->headroom + ra->chunk);
+        }
+        if (!ra->buffers[i]) {
+            free_readahead(ra);
+            return false;
+        }
+    }
+
+    if (ra->positional) {
+        ra->uring = csvkit_uring_open((unsigned)ra->buffer_count);
+        if (ra->uring) {
+            ra->offsets = calloc(ra->buffer_count, sizeof(uint64_t));
+            ra->errors = calloc(ra->buffer_count, sizeof(int));
+            ra->done = calloc(ra->buffer_count, sizeof(bool));
+            if (!ra->offsets || !ra->errors || !ra->done) {
+                free_readahead(ra);
+                return false;
+            }
+        }
+    }
+
+    pthread_mutex_init(&ra->lock, NULL);
+    pthread_cond_init(&ra->filled, NULL);
+    pthread_cond_init(&ra->released, NULL);
+    if (ra->uring) {
+        queue_free_buffers(ra);
+    } else if (pthread_create(&ra->thread, NULL, reader_main, ra) != 0) {
+        pthread_cond_destroy(&ra->released);
+        pthread_cond_destroy(&ra->filled);
+        pthread_mutex_destroy(&ra->lock);
+        free_readahead(ra);
+        return false;
+    }
+
+    parser->readahead = ra;
+    return true;
+}
+
+/* Continue an unfinished row longer than the headroom in input_buf */
+static bool carry_to_input_buf(csvkit_parser_t *parser, const char *keep_data, size_t keep,
+                               const char *data, size_t got) {
+    bool in_buf = parser->input == parser->input_buf;
+    if (in_buf && keep > 0) {
+        memmove(parser->input_buf, keep_data, keep);
+    }
+
+    size_t needed = keep + got;
+    if (needed > parser->input_capacity) {
+        size_t capacity = parser->input_capacity ? parser->input_capacity : DEFAULT_INPUT_BUFFER_SIZE;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        char *new_buf = realloc(parser->input_buf, capacity);
+        if (!new_buf) return false;
+        parser->input_buf = new_buf;
+        parser->input_capacity = capacity;
+    }
+
+    if (!in_buf) {
+        memcpy(parser->input_buf, keep_data, keep);
+    }
+    memcpy(parser->input_buf + keep, data, got);
+    parser->input = parser->input_buf;
+    return true;
+}
+
+bool csvkit_readahead_fill(csvkit_parser_t *parser) {
+    csvkit_readahead_t *ra = parser->readahead;
+    const char *keep_data = parser->input ? parser->input + parser->row_start : NULL;
+    size_t keep = parser->input_len - parser->row_start;
+
+    size_t slot;
+    if (!take_buffer(ra, &slot)) {
+        /* The window keeps the unfinished row for the parser to finish */
+        parser->input_errno = ra->error;
+        parser->input_eof = true;
+        return false;
+    }
+
+    char *data = ra->buffers[slot] + ra->headroom;
+    size_t got = ra->lengths[slot];
+    if (ra->skip > 0) {
+        size_t skip = ra->skip < got ? ra->skip : got;
+        data += skip;
+        got -= skip;
+        ra->skip = 0;
+        if (got == 0) {
+            /* The file ends before the parser's position */
+            give_back(ra, false, false);
+            parser->input_eof = true;
+            return false;
+        }
+    }
+    bool in_slot = keep <= ra->headroom;
+    bool ok = true;
+
+    if (in_slot) {
+        if (keep > 0) {
+            memcpy(data - keep, keep_data, keep);
+        }
+        parser->input = data - keep;
+    } else {
+        ok = carry_to_input_buf(parser, keep_data, keep, data, got);
+    }
+
+    if (ok) {
+        parser->input_offset += parser->row_start;
+        parser->input_pos = keep;
+        parser->input_len = keep + got;
+        parser->row_start = 0;
+    } else {
+        parser->input_errno = ENOMEM;
+        parser->input_eof = true;
+    }
+
+    give_back(ra, ok, in_slot);
+    return ok;
+}
+
+void csvkit_readahead_stop(csvkit_parser_t *parser) {
+    csvkit_readahead_t *ra = parser->readahead;
+    if (!ra) return;
+
+    if (ra->uring) {
+        /* The kernel writes into the buffers until their reads complete */
+        while (ra->in_flight > 0) {
+            if (!complete_read(ra)) {
+                ra->buffer_count = 0;  /* Leak the buffers rather than risk that */
+                break;
+            }
+        }
+    } else {
+        pthread_mutex_lock(&ra->lock);
+        ra->stop = true;
+        pthread_cond_signal(&ra->released);
+        pthread_mutex_unlock(&ra->lock);
+
+        if (ra->poll_fd) {
+            ssize_t ignored = write(ra->wake[1], "", 1);
+            (void)ignored;
+        }
+        pthread_join(ra->thread, NULL);
+    }
+
+    pthread_cond_destroy(&ra->released);
+    pthread_cond_destroy(&ra->filled);
+    pthread_mutex_destroy(&ra->lock);
+    free_readahead(ra);
+    parser->readahead = NULL;
+}
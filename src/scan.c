@@ -0,0 +1,443 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+#include "scan.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CSVKIT_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+typedef size_t (*scan_fn)(const char *p, size_t len, char a, char b, char c);
+
+static size_t scan_scalar(const char *p, size_t len, char a, char b, char c) {
+    size_t i = 0;
+    while (i < len && p[i] != a && p[i] != b && p[i] != c) {
+        i++;
+    }
+    return i;
+}
+
+/* SWAR: test eight bytes per step. A byte of (x - 0x01..) & ~x & 0x80..
+ * is set for each zero byte of x; bits above the first match may be
+ * false positives, so only the lowest one is used. */
+#define SWAR_ONES  UINT64_C(0x0101010101010101)
+#define SWAR_HIGHS UINT64_C(0x8080808080808080)
+
+static inline uint64_t swar_zero_bytes(uint64_t x) {
+    return (x - SWAR_ONES) & ~x & SWAR_HIGHS;
+}
+
+static size_t scan_swar(const char *p, size_t len, char a, char b, char c) {
+    const uint64_t ma = SWAR_ONES * (unsigned char)a;
+    const uint64_t mb = SWAR_ONES * (unsigned char)b;
+    const uint64_t mc = SWAR_ONES * (unsigned char)c;
+    const uint16_t probe = 1;
+    const int little_endian = *(const unsigned char *)&probe == 1;
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        uint64_t hits = swar_zero_bytes(word ^ ma) |
+                        swar_zero_bytes(word ^ mb) |
+                        swar_zero_bytes(word ^ mc);
+        if (hits) {
+#if defined(__GNUC__)
+            if (little_endian) {
+                return i + (size_t)(__builtin_ctzll(hits) >> 3);
+            }
+#else
+            (void)little_endian;
+#endif
+            return i + scan_scalar(p + i, 8, a, b, c);
+        }
+    }
+
+    return i + scan_scalar(p + i, len - i, a, b, c);
+}
+
+#ifdef CSVKIT_SCAN_X86
+
+__attribute__((target("sse2")))
+static size_t scan_sse2(const char *p, size_t len, char a, char b, char c) {
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(p + i));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va),
+                                                 _mm_cmpeq_epi8(v, vb)),
+                                    _mm_cmpeq_epi8(v, vc));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + scan_scalar(p + i, len - i, a, b, c);
+}
+
+/* 64 bytes per iteration in two 32-byte lanes */
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char *p, size_t len, char a, char b, char c) {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const __m256i vc = _mm256_set1_epi8(c);
+    size_t i = 0;
+
+    for (; i + 64 <= len; i += 64) {
+        __m256i lo = _mm256_loadu_si256((const __m256i *)(const void *)(p + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i *)(const void *)(p + i + 32));
+        __m256i hits_lo = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lo, va),
+                                                          _mm256_cmpeq_epi8(lo, vb)),
+                                          _mm256_cmpeq_epi8(lo, vc));
+        __m256i hits_hi = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(hi, va),
+                                                          _mm256_cmpeq_epi8(hi, vb)),
+                                          _mm256_cmpeq_epi8(hi, vc));
+        uint64_t mask = (uint32_t)_mm256_movemask_epi8(hits_lo) |
+                        ((uint64_t)(uint32_t)_mm256_movemask_epi8(hits_hi) << 32);
+        if (mask) {
+            return i + (size_t)__builtin_ctzll(mask);
+        }
+    }
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)(p + i));
+        __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, va),
+                                                       _mm256_cmpeq_epi8(v, vb)),
+                                       _mm256_cmpeq_epi8(v, vc));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(hits);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + scan_sse2(p + i, len - i, a, b, c);
+}
+
+#endif /* CSVKIT_SCAN_X86 */
+
+/* Implementations are chosen on first use. Parser threads may race on
+ * the first call; they all store the same value, and relaxed atomics
+ * keep that well-defined where the compiler offers them. */
+#ifdef __GNUC__
+#define LOAD_IMPL(ptr) __atomic_load_n(&(ptr), __ATOMIC_RELAXED)
+#define STORE_IMPL(ptr, value) __atomic_store_n(&(ptr), (value), __ATOMIC_RELAXED)
+#else
+#define LOAD_IMPL(ptr) (ptr)
+#define STORE_IMPL(ptr, value) ((ptr) = (value))
+#endif
+
+static size_t scan_resolve(const char *p, size_t len, char a, char b, char c);
+
+static scan_fn scan_impl = scan_resolve;
+
+static size_t scan_resolve(const char *p, size_t len, char a, char b, char c) {
+    scan_fn impl = scan_swar;
+
+#ifdef CSVKIT_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        impl = scan_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        impl = scan_sse2;
+    }
+#endif
+
+    STORE_IMPL(scan_impl, impl);
+    return impl(p, len, a, b, c);
+}
+
+size_t csvkit_scan_run(const char *p, size_t len, char a, char b, char c) {
+    /* Most fields are short; skip the dispatch for them */
+    if (len < 16) {
+        return scan_scalar(p, len, a, b, c);
+    }
+    return LOAD_IMPL(scan_impl)(p, len, a, b, c);
+}
+
+/*
+ * Writer quoting scan: the same scan for a delimiter, a quote, CR and LF
+ */
+
+static size_t special_scalar(const char *p, size_t len, char delimiter, char quote) {
+    size_t i = 0;
+    while (i < len && p[i] != delimiter && p[i] != quote && p[i] != '\n' && p[i] != '\r') {
+        i++;
+    }
+    return i;
+}
+
+#ifdef CSVKIT_SCAN_X86
+
+/* Fields shorter than a vector are read as two overlapping words of 8
+ * (or 4) bytes, so that no loop exit depends on the field's length */
+static size_t special_short(const char *p, size_t len, char delimiter, char quote) {
+    if (len < 4) {
+        return special_scalar(p, len, delimiter, quote);
+    }
+
+    const uint64_t md = SWAR_ONES * (unsigned char)delimiter;
+    const uint64_t mq = SWAR_ONES * (unsigned char)quote;
+    const uint64_t mlf = SWAR_ONES * (unsigned char)'\n';
+    const uint64_t mcr = SWAR_ONES * (unsigned char)'\r';
+    size_t width = len < 8 ? 4 : 8;
+    size_t starts[2] = {0, len - width};
+
+    for (int k = 0; k < 2; k++) {
+        uint64_t word = 0;
+        memcpy(&word, p + starts[k], width);
+        uint64_t hits = swar_zero_bytes(word ^ md) |
+                        swar_zero_bytes(word ^ mq) |
+                        swar_zero_bytes(word ^ mlf) |
+                        swar_zero_bytes(word ^ mcr);
+        if (width == 4) {
+            hits &= UINT64_C(0x80808080);  /* The padding bytes are not input */
+        }
+        if (hits) {
+            return starts[k] + (size_t)(__builtin_ctzll(hits) >> 3);
+        }
+    }
+    return len;
+}
+
+__attribute__((target("sse2")))
+static inline unsigned special_mask_sse2(const char *p, __m128i vd, __m128i vq) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(const void *)p);
+    __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, vd), _mm_cmpeq_epi8(v, vq)),
+                                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                                             _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    return (unsigned)_mm_movemask_epi8(hits);
+}
+
+__attribute__((target("sse2")))
+static size_t special_sse2(const char *p, size_t len, char delimiter, char quote) {
+    if (len < 16) {
+        return special_short(p, len, delimiter, quote);
+    }
+
+    const __m128i vd = _mm_set1_epi8(delimiter);
+    const __m128i vq = _mm_set1_epi8(quote);
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        unsigned mask = special_mask_sse2(p + i, vd, vq);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    if (i < len) {
+        /* The last 16 bytes; those already checked hold no match */
+        unsigned mask = special_mask_sse2(p + len - 16, vd, vq);
+        if (mask) {
+            return len - 16 + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return len;
+}
+
+#else
+
+static size_t special_swar(const char *p, size_t len, char delimiter, char quote) {
+    const uint64_t md = SWAR_ONES * (unsigned char)delimiter;
+    const uint64_t mq = SWAR_ONES * (unsigned char)quote;
+    const uint64_t mlf = SWAR_ONES * (unsigned char)'\n';
+    const uint64_t mcr = SWAR_ONES * (unsigned char)'\r';
+    size_t i = 0;
+
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        uint64_t hits = swar_zero_bytes(word ^ md) |
+                        swar_zero_bytes(word ^ mq) |
+                        swar_zero_bytes(word ^ mlf) |
+                        swar_zero_bytes(word ^ mcr);
+        if (hits) {
+            return i + special_scalar(p + i, 8, delimiter, quote);
+        }
+    }
+
+    return i + special_scalar(p + i, len - i, delimiter, quote);
+}
+
+#endif /* CSVKIT_SCAN_X86 */
+
+/* SSE2 is part of x86-64, so it needs no dispatch. Most fields are
+ * shorter than a 32-byte vector, and AVX2 would not pay for the call
+ * through a pointer. */
+size_t csvkit_scan_special(const char *p, size_t len, char delimiter, char quote) {
+#ifdef CSVKIT_SCAN_X86
+    return special_sse2(p, len, delimiter, quote);
+#else
+    if (len < 16) {
+        return special_scalar(p, len, delimiter, quote);
+    }
+    return special_swar(p, len, delimiter, quote);
+#endif
+}
+
+/*
+ * Structural index
+ */
+
+typedef size_t (*index_fn)(const char *p, size_t len, char delimiter, char quote,
+                           uint32_t *out);
+
+static inline unsigned lowest_bit(uint64_t x) {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(x);
+#else
+    unsigned n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Append the positions of the set bits of `bits` to out */
+static inline size_t flatten_bits(uint64_t bits, size_t base, uint32_t *out, size_t n) {
+    while (bits) {
+        out[n++] = (uint32_t)(base + lowest_bit(bits));
+        bits &= bits - 1;
+    }
+    return n;
+}
+
+/* Bit i of the result is the XOR of bits 0..i: set from an opening quote
+ * up to (not including) its closing quote */
+static inline uint64_t prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+static size_t index_generic(const char *p, size_t len, char delimiter, char quote,
+                            uint32_t *out) {
+    uint64_t carry = 0;  /* All ones while inside quotes across blocks */
+    size_t n = 0;
+
+    for (size_t base = 0; base < len; base += 64) {
+        size_t block = len - base < 64 ? len - base : 64;
+        uint64_t quotes = 0;
+        uint64_t structurals = 0;
+
+        for (size_t i = 0; i < block; i++) {
+            char ch = p[base + i];
+            quotes |= (uint64_t)(ch == quote) << i;
+            structurals |= (uint64_t)(ch == delimiter || ch == '\r' || ch == '\n') << i;
+        }
+
+        uint64_t inside = prefix_xor(quotes) ^ carry;
+        carry = (uint64_t)0 - (inside >> 63);
+        n = flatten_bits(structurals & ~inside, base, out, n);
+    }
+
+    return n;
+}
+
+#ifdef CSVKIT_SCAN_X86
+
+__attribute__((target("avx2")))
+static inline uint64_t match_mask_avx2(__m256i lo, __m256i hi, __m256i v) {
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, v)) |
+           ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, v)) << 32);
+}
+
+__attribute__((target("avx2,pclmul")))
+static size_t index_avx2(const char *p, size_t len, char delimiter, char quote,
+                         uint32_t *out) {
+    const __m256i vquote = _mm256_set1_epi8(quote);
+    const __m256i vdelim = _mm256_set1_epi8(delimiter);
+    const __m256i vcr = _mm256_set1_epi8('\r');
+    const __m256i vlf = _mm256_set1_epi8('\n');
+    const __m128i all_ones = _mm_set1_epi8((char)0xFF);
+    uint64_t carry = 0;
+    size_t n = 0;
+    size_t base = 0;
+
+    for (; base + 64 <= len; base += 64) {
+        __m256i lo = _mm256_loadu_si256((const __m256i *)(const void *)(p + base));
+        __m256i hi = _mm256_loadu_si256((const __m256i *)(const void *)(p + base + 32));
+
+        uint64_t quotes = match_mask_avx2(lo, hi, vquote);
+        uint64_t structurals = match_mask_avx2(lo, hi, vdelim) |
+                               match_mask_avx2(lo, hi, vcr) |
+                               match_mask_avx2(lo, hi, vlf);
+
+        /* Carry-less multiply by all ones computes the prefix XOR */
+        __m128i product = _mm_clmulepi64_si128(
+            _mm_set_epi64x(0, (long long)quotes), all_ones, 0);
+        uint64_t inside = (uint64_t)_mm_cvtsi128_si64(product) ^ carry;
+        carry = (uint64_t)0 - (inside >> 63);
+
+        n = flatten_bits(structurals & ~inside, base, out, n);
+    }
+
+    if (base < len) {
+        /* Finish the tail, continuing the quote state */
+        size_t tail_start = n;
+        if (carry) {
+            /* Inside quotes: nothing is structural until the next quote */
+            const char *close = memchr(p + base, quote, len - base);
+            if (!close) return n;
+            size_t resume = (size_t)(close - p) + 1;
+            n += index_generic(p + resume, len - resume, delimiter, quote, out + n);
+            for (size_t i = tail_start; i < n; i++) {
+                out[i] += (uint32_t)resume;
+            }
+        } else {
+            n += index_generic(p + base, len - base, delimiter, quote, out + n);
+            for (size_t i = tail_start; i < n; i++) {
+                out[i] += (uint32_t)base;
+            }
+        }
+    }
+
+    return n;
+}
+
+#endif /* CSVKIT_SCAN_X86 */
+
+static size_t index_resolve(const char *p, size_t len, char delimiter, char quote,
+                            uint32_t *out);
+
+static index_fn index_impl = index_resolve;
+
+static size_t index_resolve(const char *p, size_t len, char delimiter, char quote,
+                            uint32_t *out) {
+    index_fn impl = index_generic;
+
+#ifdef CSVKIT_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("pclmul")) {
+        impl = index_avx2;
+    }
+#endif
+
+    STORE_IMPL(index_impl, impl);
+    return impl(p, len, delimiter, quote, out);
+}
+
+size_t csvkit_index_structurals(const char *p, size_t len, char delimiter, char quote,
+                                uint32_t *out) {
+    return LOAD_IMPL(index_impl)(p, len, delimiter, quote, out);
+}
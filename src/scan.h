@@ -0,0 +1,36 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/* Internal byte scanning helpers - not part of the public API */
+
+#ifndef CSVKIT_SCAN_H
+#define CSVKIT_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Count leading bytes of p[0..len) that differ from a, b and c.
+ * Uses AVX2 or SSE2 when the CPU supports them, SWAR otherwise. */
+size_t csvkit_scan_run(const char *p, size_t len, char a, char b, char c);
+
+/* Count leading bytes of p[0..len) that differ from delimiter, quote,
+ * CR and LF: the bytes that make the writer quote a field. Uses SSE2
+ * on x86-64 and SWAR elsewhere. */
+size_t csvkit_scan_special(const char *p, size_t len, char delimiter, char quote);
+
+/* Record the offsets of delimiters, CRs and LFs lying outside quoted
+ * regions of p[0..len), with p starting outside quotes. Quote state is
+ * tracked by prefix-XOR of the quote bitmap (carry-less multiply where
+ * available), so every quote toggles it. Writes at most len offsets to
+ * out and returns their number. len must fit in 32 bits. */
+size_t csvkit_index_structurals(const char *p, size_t len, char delimiter, char quote,
+                                uint32_t *out);
+
+#endif /* CSVKIT_SCAN_H */
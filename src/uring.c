@@ -0,0 +1,230 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Minimal io_uring client for read-ahead on regular files.
+ *
+ * Only what read-ahead needs: one submission and one completion queue,
+ * IORING_OP_READ, and a blocking wait. The rings are driven through the
+ * raw system calls, so no liburing is needed. Only one thread uses a
+ * ring, so the acquire/release pairs below only order our accesses
+ * against the kernel's.
+ */
+
+#define _GNU_SOURCE
+
+#include "uring.h"
+#include <stdlib.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CSVKIT_HAVE_IO_URING 1
+#endif
+#endif
+
+#ifdef CSVKIT_HAVE_IO_URING
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+struct csvkit_uring {
+    int fd;
+    unsigned entries;
+
+    /* Submission queue */
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned to_submit;           /* Queued and not yet passed to the kernel */
+
+    /* Completion queue */
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void *sq_ring;
+    size_t sq_ring_len;
+    void *cq_ring;                /* Same as sq_ring with IORING_FEAT_SINGLE_MMAP */
+    size_t cq_ring_len;
+    size_t sqes_len;
+};
+
+static void unmap_ring(csvkit_uring_t *ring) {
+    if (ring->sqes) munmap(ring->sqes, ring->sqes_len);
+    if (ring->cq_ring && ring->cq_ring != ring->sq_ring) munmap(ring->cq_ring, ring->cq_ring_len);
+    if (ring->sq_ring) munmap(ring->sq_ring, ring->sq_ring_len);
+}
+
+csvkit_uring_t *csvkit_uring_open(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) return NULL;
+
+    /* IORING_OP_READ arrived in the same release as this feature */
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        close(fd);
+        return NULL;
+    }
+
+    csvkit_uring_t *ring = calloc(1, sizeof(csvkit_uring_t));
+    if (!ring) {
+        close(fd);
+        return NULL;
+    }
+    ring->fd = fd;
+    ring->entries = params.sq_entries;
+
+    ring->sq_ring_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && ring->cq_ring_len > ring->sq_ring_len) {
+        ring->sq_ring_len = ring->cq_ring_len;
+    }
+
+    void *sq = mmap(NULL, ring->sq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) goto fail;
+    ring->sq_ring = sq;
+
+    void *cq = sq;
+    if (!single) {
+        cq = mmap(NULL, ring->cq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED) goto fail;
+    }
+    ring->cq_ring = cq;
+
+    ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) goto fail;
+    ring->sqes = sqes;
+
+    ring->sq_head = (unsigned *)((char *)sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)((char *)sq + params.sq_off.tail);
+    ring->sq_mask = *(unsigned *)((char *)sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)((char *)sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)((char *)cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)((char *)cq + params.cq_off.tail);
+    ring->cq_mask = *(unsigned *)((char *)cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)((char *)cq + params.cq_off.cqes);
+    return ring;
+
+fail:
+    unmap_ring(ring);
+    close(fd);
+    free(ring);
+    return NULL;
+}
+
+void csvkit_uring_close(csvkit_uring_t *ring) {
+    if (!ring) return;
+
+    unmap_ring(ring);
+    close(ring->fd);
+    free(ring);
+}
+
+bool csvkit_uring_read(csvkit_uring_t *ring, int fd, void *buf, size_t len, uint64_t offset,
+                       uint64_t tag) {
+    unsigned tail = *ring->sq_tail;
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= ring->entries) return false;
+
+    unsigned index = tail & ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = (uint32_t)len;
+    sqe->off = offset;
+    sqe->user_data = tag;
+    ring->sq_array[index] = index;
+
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+    return true;
+}
+
+static bool enter(csvkit_uring_t *ring, unsigned min_complete, unsigned flags) {
+    for (;;) {
+        int n = (int)syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, min_complete, flags,
+                             NULL, 0);
+        if (n >= 0) {
+            ring->to_submit -= (unsigned)n;
+            return true;
+        }
+        if (errno != EINTR) return false;
+    }
+}
+
+bool csvkit_uring_submit(csvkit_uring_t *ring) {
+    return ring->to_submit == 0 || enter(ring, 0, 0);
+}
+
+bool csvkit_uring_wait(csvkit_uring_t *ring, uint64_t *tag, int *result) {
+    for (;;) {
+        unsigned head = *ring->cq_head;
+        if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+            *tag = cqe->user_data;
+            *result = cqe->res;
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+        if (!enter(ring, 1, IORING_ENTER_GETEVENTS)) return false;
+    }
+}
+
+#else /* !CSVKIT_HAVE_IO_URING */
+
+csvkit_uring_t *csvkit_uring_open(unsigned entries) {
+    (void)entries;
+    return NULL;
+}
+
+void csvkit_uring_close(csvkit_uring_t *ring) {
+    (void)ring;
+}
+
+bool csvkit_uring_read(csvkit_uring_t *ring, int fd, void *buf, size_t len, uint64_t offset,
+                       uint64_t tag) {
+    (void)ring;
+    (void)fd;
+    (void)buf;
+    (void)len;
+    (void)offset;
+    (void)tag;
+    return false;
+}
+
+bool csvkit_uring_submit(csvkit_uring_t *ring) {
+    (void)ring;
+    return false;
+}
+
+bool csvkit_uring_wait(csvkit_uring_t *ring, uint64_t *tag, int *result) {
+    (void)ring;
+    (void)tag;
+    (void)result;
+    return false;
+}
+
+#endif /* CSVKIT_HAVE_IO_URING */
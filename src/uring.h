@@ -0,0 +1,40 @@
+/*
+ * libcsvkit - CSV parsing library for C
+ * Copyright (C) 2025 AnmiTaliDev <anmitali198@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ */
+
+/* Internal io_uring wrapper for asynchronous file reads - not part of the public API */
+
+#ifndef CSVKIT_URING_H
+#define CSVKIT_URING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct csvkit_uring csvkit_uring_t;
+
+/* Set up a ring for up to `entries` reads in flight. Returns NULL when
+ * io_uring is not available (not Linux, an old kernel, or a sandbox
+ * that forbids it), in which case the caller falls back to pread(). */
+csvkit_uring_t *csvkit_uring_open(unsigned entries);
+void csvkit_uring_close(csvkit_uring_t *ring);
+
+/* Queue a read of len bytes at offset into buf, tagged for its
+ * completion. Returns false if the ring is full. */
+bool csvkit_uring_read(csvkit_uring_t *ring, int fd, void *buf, size_t len, uint64_t offset,
+                       uint64_t tag);
+
+/* Start the queued reads without waiting for them */
+bool csvkit_uring_submit(csvkit_uring_t *ring);
+
+/* Submit queued reads and wait for one completion. *result is the byte
+ * count or a negative errno. Returns false if the ring itself failed. */
+bool csvkit_uring_wait(csvkit_uring_t *ring, uint64_t *tag, int *result);
+
+#endif /* CSVKIT_URING_H */
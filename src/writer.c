@@ -11,15 +11,29 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "csvkit.h"
+#include "compress.h"
+#include "format.h"
+#include "scan.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
+/* Rows are formatted into the output buffer, which is written out (or
+ * passed to the compressor) whenever it fills up */
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+
 struct csvkit_writer {
     csvkit_config_t config;
     FILE *file;
     bool owns_file;
     char *error_msg;
+
+    char *buffer;                 /* Formatted output not yet written */
+    size_t buffered;
+    csvkit_encoder_t *encoder;    /* Compressor for config.compression */
+
+    bool check_values;            /* Typed values can contain the delimiter or quote */
+    size_t row_fields;            /* Fields of the row being built one at a time */
 };
 
 static void set_error(csvkit_writer_t *writer, const char *msg) {
@@ -51,19 +65,72 @@ static bool validate_config(const csvkit_config_t *config) {
         return false;
     }
 
+    if (config->compression != CSVKIT_COMPRESSION_NONE &&
+        config->compression != CSVKIT_COMPRESSION_GZIP &&
+        config->compression != CSVKIT_COMPRESSION_ZSTD) {
+        return false;
+    }
+
     return true;
 }
 
-static bool needs_quoting(const char *field, char delimiter, char quote_char) {
-    if (!field) return false;
+/* Bytes that formatted numbers, dates, timestamps and booleans can
+ * contain. Unless the delimiter or quote is one of them, typed values
+ * never need quoting. */
+static const char value_chars[] = "0123456789+-.:Tadefilnrstu";
 
-    for (const char *p = field; *p; p++) {
-        if (*p == delimiter || *p == quote_char || *p == '\n' || *p == '\r') {
-            return true;
-        }
+static bool value_needs_check(const csvkit_config_t *config) {
+    return memchr(value_chars, config->delimiter, sizeof(value_chars) - 1) != NULL ||
+           memchr(value_chars, config->quote_char, sizeof(value_chars) - 1) != NULL;
+}
+
+/* Write bytes to the file, through the compressor when there is one */
+static bool write_out(csvkit_writer_t *writer, const char *data, size_t len) {
+    if (writer->encoder) {
+        return csvkit_encoder_write(writer->encoder, data, len, writer->file);
     }
+    return fwrite(data, 1, len, writer->file) == len;
+}
 
-    return false;
+/* Write out the output buffer. Its contents are dropped on failure. */
+static bool flush_buffer(csvkit_writer_t *writer) {
+    if (writer->buffered == 0) return true;
+
+    bool ok = write_out(writer, writer->buffer, writer->buffered);
+    writer->buffered = 0;
+    return ok;
+}
+
+static inline bool put_char(csvkit_writer_t *writer, char c) {
+    if (writer->buffered == OUTPUT_BUFFER_SIZE && !flush_buffer(writer)) return false;
+    writer->buffer[writer->buffered++] = c;
+    return true;
+}
+
+static bool put_data(csvkit_writer_t *writer, const char *data, size_t len) {
+    if (len > OUTPUT_BUFFER_SIZE - writer->buffered) {
+        if (!flush_buffer(writer)) return false;
+        /* Too big to gain from buffering */
+        if (len >= OUTPUT_BUFFER_SIZE) return write_out(writer, data, len);
+    }
+    memcpy(writer->buffer + writer->buffered, data, len);
+    writer->buffered += len;
+    return true;
+}
+
+/* Set up compression of the output opened next */
+static csvkit_error_t start_encoder(csvkit_writer_t *writer) {
+    if (writer->config.compression == CSVKIT_COMPRESSION_NONE) return CSVKIT_OK;
+
+    const char *error = NULL;
+    writer->encoder = csvkit_encoder_new(writer->config.compression,
+                                         writer->config.compression_level,
+                                         writer->config.compression_threads, &error);
+    if (!writer->encoder) {
+        set_error(writer, error);
+        return CSVKIT_ERROR_INVALID_ARG;
+    }
+    return CSVKIT_OK;
 }
 
 csvkit_writer_t *csvkit_writer_new(void) {
@@ -79,10 +146,17 @@ csvkit_writer_t *csvkit_writer_new_with_config(const csvkit_config_t *config) {
     csvkit_writer_t *writer = calloc(1, sizeof(csvkit_writer_t));
     if (!writer) return NULL;
 
+    writer->buffer = malloc(OUTPUT_BUFFER_SIZE);
+    if (!writer->buffer) {
+        free(writer);
+        return NULL;
+    }
+
     writer->config = *config;
     writer->file = NULL;
     writer->owns_file = false;
     writer->error_msg = NULL;
+    writer->check_values = value_needs_check(config);
 
     return writer;
 }
@@ -92,12 +166,19 @@ csvkit_error_t csvkit_writer_open_file(csvkit_writer_t *writer, const char *file
 
     csvkit_writer_close(writer);
 
-    FILE *file = fopen(filename, "w");
+    csvkit_error_t err = start_encoder(writer);
+    if (err != CSVKIT_OK) return err;
+
+    FILE *file = fopen(filename, writer->encoder ? "wb" : "w");
     if (!file) {
+        csvkit_writer_close(writer);
         set_error(writer, "Failed to open file for writing");
         return CSVKIT_ERROR_IO;
     }
 
+    /* Whole buffers are written at once, so stdio need not copy them */
+    setvbuf(file, NULL, _IONBF, 0);
+
     writer->file = file;
     writer->owns_file = true;
 
@@ -109,86 +190,430 @@ csvkit_error_t csvkit_writer_open_stream(csvkit_writer_t *writer, FILE *stream)
 
     csvkit_writer_close(writer);
 
+    csvkit_error_t err = start_encoder(writer);
+    if (err != CSVKIT_OK) return err;
+
     writer->file = stream;
     writer->owns_file = false;
 
     return CSVKIT_OK;
 }
 
+/* Characters the formatter uses, copied out of the config once per call
+ * so that they stay in registers while the buffer is written */
+typedef struct {
+    char delimiter;
+    char quote;
+    char escape;
+} format_t;
+
+static inline format_t writer_format(const csvkit_writer_t *writer) {
+    format_t format = {writer->config.delimiter, writer->config.quote_char,
+                       writer->config.escape_char};
+    return format;
+}
+
+/* Format a field straight into the output buffer, which has room for
+ * it even if every byte is a quote to escape */
+static inline char *format_field(char *out, format_t format, const char *field, size_t len) {
+    size_t plain = csvkit_scan_special(field, len, format.delimiter, format.quote);
+    if (plain == len) {
+        memcpy(out, field, len);
+        return out + len;
+    }
+
+    *out++ = format.quote;
+    memcpy(out, field, plain);
+    out += plain;
+
+    const char *p = field + plain;
+    const char *end = field + len;
+    if (end - p >= 64) {
+        /* Copy the runs between quote characters */
+        const char *hit;
+        while ((hit = memchr(p, format.quote, (size_t)(end - p))) != NULL) {
+            memcpy(out, p, (size_t)(hit - p));
+            out += hit - p;
+            *out++ = format.escape;
+            *out++ = format.quote;
+            p = hit + 1;
+        }
+    }
+    for (; p < end; p++) {
+        if (*p == format.quote) {
+            *out++ = format.escape;
+        }
+        *out++ = *p;
+    }
+
+    *out++ = format.quote;
+    return out;
+}
+
+static bool write_field(csvkit_writer_t *writer, format_t format, const char *field, size_t len) {
+    if (len == 0) return true;
+
+    /* Fields that fit whatever their contents skip the per-copy checks */
+    size_t room = OUTPUT_BUFFER_SIZE - writer->buffered;
+    if (room >= 2 && len <= (room - 2) / 2) {
+        char *out = format_field(writer->buffer + writer->buffered, format, field, len);
+        writer->buffered = (size_t)(out - writer->buffer);
+        return true;
+    }
+
+    /* One scan decides quoting: bytes before the first special one need
+     * no escaping, and most fields have none at all */
+    size_t plain = csvkit_scan_special(field, len, format.delimiter, format.quote);
+    if (plain == len) {
+        return put_data(writer, field, len);
+    }
+
+    if (!put_char(writer, format.quote) || !put_data(writer, field, plain)) return false;
+
+    /* Copy the runs between quote characters, escaping each quote */
+    const char *p = field + plain;
+    const char *end = field + len;
+    const char *hit;
+    while ((hit = memchr(p, format.quote, (size_t)(end - p))) != NULL) {
+        if (!put_data(writer, p, (size_t)(hit - p)) ||
+            !put_char(writer, format.escape) ||
+            !put_char(writer, format.quote)) {
+            return false;
+        }
+        p = hit + 1;
+    }
+
+    return put_data(writer, p, (size_t)(end - p)) && put_char(writer, format.quote);
+}
+
+/* Write one row whose i-th field is fields[i * stride], measuring fields
+ * with strlen() when lengths is NULL */
+static bool write_fields(csvkit_writer_t *writer, format_t format, const char **fields,
+                         const size_t *lengths, size_t field_count, size_t stride) {
+    for (size_t i = 0; i < field_count; i++) {
+        if (i > 0 && !put_char(writer, format.delimiter)) return false;
+
+        const char *field = fields[i * stride];
+        size_t len = 0;
+        if (field) {
+            len = lengths ? lengths[i * stride] : strlen(field);
+        }
+        if (!write_field(writer, format, field, len)) return false;
+    }
+
+    return put_char(writer, '\n');
+}
+
+/* Record a failed write: the compressor's reason, or a stream error */
+static csvkit_error_t write_failed(csvkit_writer_t *writer) {
+    const char *msg = csvkit_encoder_error(writer->encoder);
+    set_error(writer, msg ? msg : "Write error");
+    return CSVKIT_ERROR_IO;
+}
+
+/* Whole rows cannot be written while one is being built field by field */
+static csvkit_error_t row_in_progress(csvkit_writer_t *writer) {
+    set_error(writer, "A row is in progress; end it with csvkit_writer_end_row()");
+    return CSVKIT_ERROR_INVALID_ARG;
+}
+
 csvkit_error_t csvkit_writer_write_row(csvkit_writer_t *writer, const char **fields, size_t field_count) {
     if (!writer || !writer->file) return CSVKIT_ERROR_INVALID_ARG;
+    if (writer->row_fields > 0) return row_in_progress(writer);
     if (!fields && field_count > 0) return CSVKIT_ERROR_INVALID_ARG;
 
-    for (size_t i = 0; i < field_count; i++) {
-        if (i > 0) {
-            if (fputc(writer->config.delimiter, writer->file) == EOF) {
-                set_error(writer, "Write error");
-                return CSVKIT_ERROR_IO;
-            }
+    if (!write_fields(writer, writer_format(writer), fields, NULL, field_count, 1)) {
+        return write_failed(writer);
+    }
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_writer_write_row_n(csvkit_writer_t *writer, const char **fields,
+                                         const size_t *lengths, size_t field_count) {
+    if (!writer || !writer->file) return CSVKIT_ERROR_INVALID_ARG;
+    if (writer->row_fields > 0) return row_in_progress(writer);
+    if ((!fields || !lengths) && field_count > 0) return CSVKIT_ERROR_INVALID_ARG;
+
+    if (!write_fields(writer, writer_format(writer), fields, lengths, field_count, 1)) {
+        return write_failed(writer);
+    }
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_writer_write_rows(csvkit_writer_t *writer, const char **fields,
+                                        const size_t *lengths, size_t row_count,
+                                        size_t column_count, csvkit_layout_t layout) {
+    if (!writer || !writer->file) return CSVKIT_ERROR_INVALID_ARG;
+    if (writer->row_fields > 0) return row_in_progress(writer);
+    if (layout != CSVKIT_ROW_MAJOR && layout != CSVKIT_COLUMN_MAJOR) return CSVKIT_ERROR_INVALID_ARG;
+    if (!fields && row_count > 0 && column_count > 0) return CSVKIT_ERROR_INVALID_ARG;
+
+    /* Row r starts at fields[r * column_count] with consecutive columns
+     * (row-major), or at fields[r] with columns row_count apart */
+    bool row_major = layout == CSVKIT_ROW_MAJOR;
+    size_t row_step = row_major ? column_count : 1;
+    size_t stride = row_major ? 1 : row_count;
+    format_t format = writer_format(writer);
+
+    for (size_t row = 0; row < row_count; row++) {
+        size_t first = row * row_step;
+        if (!write_fields(writer, format, fields + first, lengths ? lengths + first : NULL,
+                          column_count, stride)) {
+            return write_failed(writer);
         }
+    }
 
-        const char *field = fields[i] ? fields[i] : "";
+    return CSVKIT_OK;
+}
 
-        if (needs_quoting(field, writer->config.delimiter, writer->config.quote_char)) {
-            /* Write quoted field */
-            if (fputc(writer->config.quote_char, writer->file) == EOF) {
-                set_error(writer, "Write error");
-                return CSVKIT_ERROR_IO;
-            }
+static inline bool bit_is_set(const uint8_t *bits, size_t index) {
+    return (bits[index >> 3] >> (index & 7)) & 1;
+}
 
-            for (const char *p = field; *p; p++) {
-                if (*p == writer->config.quote_char) {
-                    /* Escape quote character */
-                    if (fputc(writer->config.escape_char, writer->file) == EOF ||
-                        fputc(writer->config.quote_char, writer->file) == EOF) {
-                        set_error(writer, "Write error");
-                        return CSVKIT_ERROR_IO;
-                    }
-                } else {
-                    if (fputc(*p, writer->file) == EOF) {
-                        set_error(writer, "Write error");
-                        return CSVKIT_ERROR_IO;
-                    }
-                }
-            }
+static inline char *format_bool(char *out, bool value) {
+    if (value) {
+        memcpy(out, "true", 4);
+        return out + 4;
+    }
+    memcpy(out, "false", 5);
+    return out + 5;
+}
+
+/* Typed values are formatted in place at the end of the output buffer,
+ * after making room for the longest text */
+static inline bool reserve_value(csvkit_writer_t *writer) {
+    return OUTPUT_BUFFER_SIZE - writer->buffered >= FORMAT_VALUE_MAX || flush_buffer(writer);
+}
+
+/* Take the text of a value formatted at buffer[start] into the output,
+ * rewriting it quoted if it holds the delimiter or quote */
+static bool end_value(csvkit_writer_t *writer, format_t format, size_t start, const char *end) {
+    size_t len = (size_t)(end - writer->buffer) - start;
+    writer->buffered = start + len;
+    if (!writer->check_values ||
+        csvkit_scan_special(writer->buffer + start, len, format.delimiter, format.quote) == len) {
+        return true;
+    }
+
+    char text[FORMAT_VALUE_MAX];
+    memcpy(text, writer->buffer + start, len);
+    writer->buffered = start;
+    return write_field(writer, format, text, len);
+}
+
+/* Text of a non-null value of a typed column */
+static inline char *format_value(char *out, const csvkit_column_t *column, size_t row) {
+    switch (column->type) {
+    case CSVKIT_TYPE_INT64: {
+        int64_t value;
+        memcpy(&value, column->data + row * sizeof(int64_t), sizeof(value));
+        return csvkit_format_int64(out, value);
+    }
+    case CSVKIT_TYPE_DOUBLE: {
+        double value;
+        memcpy(&value, column->data + row * sizeof(double), sizeof(value));
+        return csvkit_format_double(out, value);
+    }
+    case CSVKIT_TYPE_BOOL:
+        return format_bool(out, bit_is_set((const uint8_t *)column->data, row));
+    case CSVKIT_TYPE_DATE: {
+        int32_t value;
+        memcpy(&value, column->data + row * sizeof(int32_t), sizeof(value));
+        return csvkit_format_date(out, value);
+    }
+    case CSVKIT_TYPE_TIMESTAMP: {
+        int64_t value;
+        memcpy(&value, column->data + row * sizeof(int64_t), sizeof(value));
+        return csvkit_format_timestamp(out, value);
+    }
+    default:
+        return out;
+    }
+}
+
+static bool check_column(const csvkit_column_t *column, size_t row_count) {
+    switch (column->type) {
+    case CSVKIT_TYPE_STRING:
+        if (row_count == 0) return true;
+        if (!column->offsets || column->offsets[0] < 0) return false;
+        for (size_t row = 0; row < row_count; row++) {
+            if (column->offsets[row + 1] < column->offsets[row]) return false;
+        }
+        return column->data || column->offsets[row_count] == column->offsets[0];
+    case CSVKIT_TYPE_INT64:
+    case CSVKIT_TYPE_DOUBLE:
+    case CSVKIT_TYPE_BOOL:
+    case CSVKIT_TYPE_DATE:
+    case CSVKIT_TYPE_TIMESTAMP:
+        return column->data || row_count == 0;
+    default:
+        return false;
+    }
+}
 
-            if (fputc(writer->config.quote_char, writer->file) == EOF) {
-                set_error(writer, "Write error");
-                return CSVKIT_ERROR_IO;
+/* Write one row of a batch */
+static bool write_batch_row(csvkit_writer_t *writer, format_t format, const csvkit_batch_t *batch,
+                            size_t row) {
+    for (size_t i = 0; i < batch->column_count; i++) {
+        if (i > 0 && !put_char(writer, format.delimiter)) return false;
+
+        const csvkit_column_t *column = &batch->columns[i];
+        if (column->validity && !bit_is_set(column->validity, row)) continue;
+
+        if (column->type == CSVKIT_TYPE_STRING) {
+            int64_t start = column->offsets[row];
+            if (!write_field(writer, format, column->data + start,
+                             (size_t)(column->offsets[row + 1] - start))) {
+                return false;
             }
         } else {
-            /* Write unquoted field */
-            if (fputs(field, writer->file) == EOF) {
-                set_error(writer, "Write error");
-                return CSVKIT_ERROR_IO;
+            if (!reserve_value(writer)) return false;
+            size_t start = writer->buffered;
+            if (!end_value(writer, format, start,
+                           format_value(writer->buffer + start, column, row))) {
+                return false;
             }
         }
     }
 
-    /* Write newline */
-    if (fputc('\n', writer->file) == EOF) {
+    return put_char(writer, '\n');
+}
+
+csvkit_error_t csvkit_writer_write_batch(csvkit_writer_t *writer, const csvkit_batch_t *batch) {
+    if (!writer || !writer->file || !batch) return CSVKIT_ERROR_INVALID_ARG;
+    if (!batch->columns && batch->column_count > 0) return CSVKIT_ERROR_INVALID_ARG;
+    if (writer->row_fields > 0) return row_in_progress(writer);
+
+    /* Checked up front, so that bad buffers cannot leave half a batch */
+    for (size_t i = 0; i < batch->column_count; i++) {
+        if (!check_column(&batch->columns[i], batch->row_count)) return CSVKIT_ERROR_INVALID_ARG;
+    }
+
+    format_t format = writer_format(writer);
+    for (size_t row = 0; row < batch->row_count; row++) {
+        if (!write_batch_row(writer, format, batch, row)) {
+            return write_failed(writer);
+        }
+    }
+
+    return CSVKIT_OK;
+}
+
+/*
+ * Rows built one field at a time
+ */
+
+/* Write the delimiter before every field of the row but the first */
+static inline bool begin_field(csvkit_writer_t *writer, format_t format) {
+    return writer->row_fields++ == 0 || put_char(writer, format.delimiter);
+}
+
+csvkit_error_t csvkit_writer_write_field(csvkit_writer_t *writer, const char *data, size_t len) {
+    if (!writer || !writer->file) return CSVKIT_ERROR_INVALID_ARG;
+    if (!data && len > 0) return CSVKIT_ERROR_INVALID_ARG;
+
+    format_t format = writer_format(writer);
+    if (!begin_field(writer, format) || !write_field(writer, format, data, len)) {
+        return write_failed(writer);
+    }
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_writer_write_int64(csvkit_writer_t *writer, int64_t value) {
+    if (!writer || !writer->file) return CSVKIT_ERROR_INVALID_ARG;
+
+    format_t format = writer_format(writer);
+    if (!begin_field(writer, format) || !reserve_value(writer)) return write_failed(writer);
+    size_t start = writer->buffered;
+    if (!end_value(writer, format, start, csvkit_format_int64(writer->buffer + start, value))) {
+        return write_failed(writer);
+    }
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_writer_write_double(csvkit_writer_t *writer, double value) {
+    if (!writer || !writer->file) return CSVKIT_ERROR_INVALID_ARG;
+
+    format_t format = writer_format(writer);
+    if (!begin_field(writer, format) || !reserve_value(writer)) return write_failed(writer);
+    size_t start = writer->buffered;
+    if (!end_value(writer, format, start, csvkit_format_double(writer->buffer + start, value))) {
+        return write_failed(writer);
+    }
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_writer_write_bool(csvkit_writer_t *writer, bool value) {
+    if (!writer || !writer->file) return CSVKIT_ERROR_INVALID_ARG;
+
+    format_t format = writer_format(writer);
+    if (!begin_field(writer, format) || !reserve_value(writer)) return write_failed(writer);
+    size_t start = writer->buffered;
+    if (!end_value(writer, format, start, format_bool(writer->buffer + start, value))) {
+        return write_failed(writer);
+    }
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_writer_end_row(csvkit_writer_t *writer) {
+    if (!writer || !writer->file) return CSVKIT_ERROR_INVALID_ARG;
+
+    writer->row_fields = 0;
+    if (!put_char(writer, '\n')) return write_failed(writer);
+    return CSVKIT_OK;
+}
+
+csvkit_error_t csvkit_writer_flush(csvkit_writer_t *writer) {
+    if (!writer || !writer->file) return CSVKIT_ERROR_INVALID_ARG;
+
+    if (!flush_buffer(writer) ||
+        (writer->encoder && !csvkit_encoder_flush(writer->encoder, writer->file))) {
+        return write_failed(writer);
+    }
+    if (fflush(writer->file) != 0) {
         set_error(writer, "Write error");
         return CSVKIT_ERROR_IO;
     }
-
     return CSVKIT_OK;
 }
 
-void csvkit_writer_close(csvkit_writer_t *writer) {
-    if (!writer) return;
+csvkit_error_t csvkit_writer_close(csvkit_writer_t *writer) {
+    if (!writer) return CSVKIT_ERROR_INVALID_ARG;
+
+    csvkit_error_t result = CSVKIT_OK;
+
+    /* Finish a row left in progress, write out buffered rows and end the
+     * compressed stream before the file is closed */
+    if (writer->file) {
+        if ((writer->row_fields > 0 && !put_char(writer, '\n')) ||
+            !flush_buffer(writer) ||
+            (writer->encoder && !csvkit_encoder_finish(writer->encoder, writer->file))) {
+            result = write_failed(writer);
+        }
+    }
+    writer->buffered = 0;
+    writer->row_fields = 0;
+    csvkit_encoder_free(writer->encoder);
+    writer->encoder = NULL;
 
     if (writer->owns_file && writer->file) {
-        fclose(writer->file);
+        if (fclose(writer->file) != 0 && result == CSVKIT_OK) {
+            set_error(writer, "Write error");
+            result = CSVKIT_ERROR_IO;
+        }
     }
 
     writer->file = NULL;
     writer->owns_file = false;
+
+    return result;
 }
 
 void csvkit_writer_free(csvkit_writer_t *writer) {
     if (!writer) return;
 
     csvkit_writer_close(writer);
+    free(writer->buffer);
     free(writer->error_msg);
     free(writer);
 }